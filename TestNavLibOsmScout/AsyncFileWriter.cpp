@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include "AsyncFileWriter.h"
+
+AsyncFileWriter::AsyncFileWriter():
+	_file(nullptr),
+	_blockSize(DefaultBlockSize),
+	_current(nullptr),
+	_stop(false),
+	_failed(false) {
+}
+
+AsyncFileWriter::~AsyncFileWriter() {
+	Close();
+}
+
+AsyncFileWriter::Block* AsyncFileWriter::NewBlock() {
+	auto block = new Block;
+	block->data = new char[_blockSize];
+	block->size = 0;
+	return block;
+}
+
+void AsyncFileWriter::DeleteBlock(Block* block) {
+	delete[] block->data;
+	delete block;
+}
+
+bool AsyncFileWriter::Open(const std::string& filename, size_t blockSize) {
+	Close();
+
+	_file = std::fopen(filename.c_str(), "wb");
+	if (_file == nullptr) return false;
+	//The blocks are the buffer, stdio would only copy them once more
+	std::setvbuf(_file, nullptr, _IONBF, 0);
+
+	_blockSize = std::max<size_t>(blockSize, 256);
+	_current = NewBlock();
+	_stop = false;
+	_failed = false;
+	_thread = std::thread(&AsyncFileWriter::Run, this);
+	return true;
+}
+
+bool AsyncFileWriter::Close() {
+	if (_file == nullptr) return true;
+
+	Submit();
+	{
+		std::lock_guard<std::mutex> lock(_wakeMutex);
+		_stop = true;
+	}
+	_wake.notify_one();
+	_thread.join();
+
+	if (std::fclose(_file) != 0) {
+		_failed = true;
+	}
+	_file = nullptr;
+
+	Block* block;
+	while (_free.Pop(block)) {
+		DeleteBlock(block);
+	}
+	DeleteBlock(_current);
+	_current = nullptr;
+
+	return !_failed;
+}
+
+void AsyncFileWriter::Submit() {
+	if (_current->size == 0) return;
+
+	//Only if the disk is QueueCapacity blocks behind the writer has to wait
+	while (!_full.Push(_current)) {
+		_wake.notify_one();
+		std::this_thread::yield();
+	}
+	//Without the mutex a wake up may get lost, the background thread then finds the block on its next timeout
+	_wake.notify_one();
+
+	if (!_free.Pop(_current)) {
+		_current = NewBlock();
+	}
+}
+
+void AsyncFileWriter::Write(const char* data, size_t size) {
+	if (!IsOpen()) return;
+
+	while (size > 0) {
+		const auto count = std::min(size, _blockSize - _current->size);
+		std::memcpy(_current->data + _current->size, data, count);
+		_current->size += count;
+		data += count;
+		size -= count;
+		if (_current->size == _blockSize) {
+			Submit();
+		}
+	}
+}
+
+char* AsyncFileWriter::Reserve(size_t size) {
+	if (!IsOpen() || size > _blockSize) return nullptr;
+
+	if (_blockSize - _current->size < size) {
+		Submit();
+	}
+	return _current->data + _current->size;
+}
+
+void AsyncFileWriter::Run() {
+	for (;;) {
+		Block* block;
+		while (_full.Pop(block)) {
+			if (std::fwrite(block->data, 1, block->size, _file) != block->size) {
+				_failed = true;
+			}
+			block->size = 0;
+			if (!_free.Push(block)) {
+				DeleteBlock(block);
+			}
+		}
+
+		std::unique_lock<std::mutex> lock(_wakeMutex);
+		if (_stop && _full.Empty()) {
+			break;
+		}
+		_wake.wait_for(lock, std::chrono::milliseconds(50), [this]() {
+			return _stop || !_full.Empty();
+		});
+	}
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "SpscQueue.h"
+
+/**
+ * File output for the hot path: the writer thread only copies into the current block,
+ * full blocks go through a lock free queue to a background thread that writes them and
+ * hands them back for reuse. The file sees data only on block boundaries and on Close.
+ * One thread writes, Open and Close belong to the same thread.
+ */
+class AsyncFileWriter
+{
+public:
+	static const size_t DefaultBlockSize = 64 * 1024;
+
+private:
+	struct Block
+	{
+		char*  data;
+		size_t size;
+	};
+
+	static const size_t QueueCapacity = 64;
+
+	std::FILE*                             _file;
+	size_t                                 _blockSize;
+	Block*                                 _current;
+	SpscQueue<Block*, QueueCapacity>       _full;
+	SpscQueue<Block*, QueueCapacity>       _free;
+	std::thread                            _thread;
+	std::atomic<bool>                      _stop;
+	std::atomic<bool>                      _failed;
+	std::mutex                             _wakeMutex;
+	std::condition_variable                _wake;
+
+	Block* NewBlock();
+	void DeleteBlock(Block* block);
+	void Submit();
+	void Run();
+
+public:
+	AsyncFileWriter();
+	~AsyncFileWriter();
+	AsyncFileWriter(const AsyncFileWriter&) = delete;
+	AsyncFileWriter& operator=(const AsyncFileWriter&) = delete;
+
+	bool Open(const std::string& filename, size_t blockSize = DefaultBlockSize);
+	/**
+	 * Write the rest and wait for the file
+	 *
+	 * @return false if any write failed
+	 */
+	bool Close();
+	bool IsOpen() const
+	{
+		return _file != nullptr;
+	}
+
+	/**
+	 * Nothing happens if the writer is not open
+	 */
+	void Write(const char* data, size_t size);
+
+	void Write(const std::string& text)
+	{
+		Write(text.data(), text.size());
+	}
+
+	template<size_t N>
+	void Write(const char (&text)[N])
+	{
+		Write(text, N - 1);
+	}
+
+	/**
+	 * Room for at least size bytes in the current block, to format into directly.
+	 * Commit tells how much of it is used.
+	 *
+	 * @return nullptr if the writer is not open or size is larger than a block, Write splits larger data
+	 */
+	char* Reserve(size_t size);
+	/**
+	 * Ignored if the writer is not open or size is more than the room left in the block
+	 */
+	void Commit(size_t size)
+	{
+		if (_current == nullptr || size > _blockSize - _current->size) return;
+		_current->size += size;
+	}
+};
@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+#include "FleetSimulator.h"
+#include "IStepSource.h"
+#include "LatencyHistogram.h"
+#include "Simulator.h"
+
+//Meter per degree of latitude
+static const double MeterPerDegree = 111320.0;
+
+/**
+ * Steps of a shared track as one vehicle drives them: later, faster or slower and with GPS noise
+ */
+class JitteredStepSource : public IStepSource
+{
+	const IPathGenerator::StepTrack&  _steps;
+	size_t                            _index;
+	osmscout::Timestamp::duration     _startOffset;
+	double                            _speedFactor;
+	double                            _gpsNoiseInMeter;
+	std::mt19937                      _random;
+	std::normal_distribution<double>  _noise;
+
+public:
+	JitteredStepSource(const IPathGenerator::StepTrack& steps,
+		osmscout::Timestamp::duration startOffset,
+		double speedFactor,
+		double gpsNoiseInMeter,
+		uint32_t seed)
+		: _steps(steps),
+		_index(0),
+		_startOffset(startOffset),
+		_speedFactor(speedFactor),
+		_gpsNoiseInMeter(gpsNoiseInMeter),
+		_random(seed),
+		_noise(0.0, 1.0)
+	{
+		// no code
+	}
+
+	bool NextStep(IPathGenerator::Step& step) override
+	{
+		if (_index >= _steps.size()) return false;
+		step = _steps[_index];
+
+		//Faster vehicles need less time between the same positions
+		const auto driven = std::chrono::duration<double>(step.time - _steps.time(0)) / _speedFactor;
+		step.time = _steps.time(0) + _startOffset + std::chrono::duration_cast<osmscout::Timestamp::duration>(driven);
+		step.speed *= _speedFactor;
+
+		if (_gpsNoiseInMeter > 0) {
+			const auto lat = step.coord.GetLat();
+			const auto lon = step.coord.GetLon();
+			step.coord = osmscout::GeoCoord(
+				lat + _noise(_random) * _gpsNoiseInMeter / MeterPerDegree,
+				lon + _noise(_random) * _gpsNoiseInMeter / (MeterPerDegree * std::max(std::cos(lat * M_PI / 180), 0.01)));
+		}
+
+		_index++;
+		return true;
+	}
+};
+
+FleetSimulator::FleetSimulator()
+	: _startJitterInSeconds(300.0),
+	_speedJitter(0.1),
+	_gpsNoiseInMeter(5.0)
+{
+	// no code
+}
+
+void FleetSimulator::AddRoute(const osmscout::RoutePointsRef& points,
+	const osmscout::RouteDescriptionRef& description,
+	const IPathGenerator& generator)
+{
+	_routes.push_back(Route{ points, description, &generator });
+}
+
+void FleetSimulator::SetJitter(double startJitterInSeconds, double speedJitter, double gpsNoiseInMeter)
+{
+	_startJitterInSeconds = startJitterInSeconds;
+	_speedJitter = speedJitter;
+	_gpsNoiseInMeter = gpsNoiseInMeter;
+}
+
+void FleetSimulator::Run(const osmscout::DatabaseRef& database, size_t vehicleCount, size_t threadCount)
+{
+	struct Vehicle
+	{
+		size_t                        route;
+		osmscout::Timestamp::duration startOffset;
+		double                        speedFactor;
+		size_t                        fixCount;
+		LatencyHistogram              latency;
+	};
+
+	if (_routes.empty() || vehicleCount == 0) {
+		std::cerr << "No routes or vehicles for the fleet" << std::endl;
+		return;
+	}
+	threadCount = std::max<size_t>(1, std::min(threadCount, vehicleCount));
+
+	//Same fleet on every run, the jitter comes from a fixed seed
+	std::vector<Vehicle> vehicles(vehicleCount);
+	std::mt19937 random(4711);
+	std::uniform_real_distribution<double> startDistribution(0.0, _startJitterInSeconds);
+	std::uniform_real_distribution<double> speedDistribution(1.0 - _speedJitter, 1.0 + _speedJitter);
+	for (size_t i = 0; i < vehicleCount; i++) {
+		vehicles[i].route = i % _routes.size();
+		vehicles[i].startOffset = std::chrono::duration_cast<osmscout::Timestamp::duration>(
+			std::chrono::duration<double>(startDistribution(random)));
+		vehicles[i].speedFactor = std::max(speedDistribution(random), 0.1);
+		vehicles[i].fixCount = 0;
+	}
+
+	std::cout << "Fleet of " << vehicleCount << " vehicles on " << _routes.size() << " routes, "
+		<< threadCount << " threads" << std::endl;
+
+	//The workers take the next vehicle until all have arrived
+	std::atomic<size_t> nextVehicle(0);
+	const auto start = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> workers;
+	workers.reserve(threadCount);
+	for (size_t i = 0; i < threadCount; i++) {
+		workers.emplace_back([this, &vehicles, &nextVehicle, &database]() {
+			for (auto index = nextVehicle++; index < vehicles.size(); index = nextVehicle++) {
+				auto& vehicle = vehicles[index];
+				const auto& route = _routes[vehicle.route];
+
+				JitteredStepSource source(route.generator->steps, vehicle.startOffset, vehicle.speedFactor,
+					_gpsNoiseInMeter, static_cast<uint32_t>(index));
+				Simulator simulator;
+				simulator.SetOutput("", false);
+				simulator.Simulate(database, source, route.points, route.description);
+
+				vehicle.fixCount = simulator.GetFixCount();
+				vehicle.latency = simulator.GetUpdateLatency();
+			}
+		});
+	}
+	for (auto& worker : workers) {
+		worker.join();
+	}
+
+	const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	LatencyHistogram total;
+	size_t fixCount = 0;
+	const auto precision = std::cout.precision();
+	for (size_t i = 0; i < vehicles.size(); i++) {
+		const auto& vehicle = vehicles[i];
+		std::cout << "Vehicle " << std::setw(4) << i << " route " << vehicle.route
+			<< " speed x" << std::fixed << std::setprecision(2) << vehicle.speedFactor
+			<< " fixes " << vehicle.fixCount
+			<< " latency us mean " << vehicle.latency.GetMean()
+			<< " p99 <= " << vehicle.latency.Percentile(99)
+			<< " max " << vehicle.latency.GetMax() << std::endl;
+		total.Merge(vehicle.latency);
+		fixCount += vehicle.fixCount;
+	}
+	std::cout.unsetf(std::ios_base::floatfield);
+	std::cout.precision(precision);
+
+	std::cout << "Fleet: " << fixCount << " fixes in " << seconds << " s, "
+		<< (seconds > 0 ? fixCount / seconds : 0.0) << " fixes/s" << std::endl;
+	std::cout << "Fix to navigation output over all vehicles ";
+	total.Print(std::cout);
+}
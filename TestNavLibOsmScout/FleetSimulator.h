@@ -0,0 +1,45 @@
+#pragma once
+#include <vector>
+#include <osmscout/navigation/Agents.h>
+#include "IPathGenerator.h"
+
+/**
+ * Load test of the navigation: many synthetic vehicles drive the generated tracks at the same time,
+ * every vehicle with its own Simulator and so its own NavigationEngine. The fixes are fed as fast
+ * as the engines take them, fixes per second over all vehicles divided by the fix rate of one
+ * receiver is the number of vehicles the box can guide.
+ */
+class FleetSimulator
+{
+	struct Route
+	{
+		osmscout::RoutePointsRef      points;
+		osmscout::RouteDescriptionRef description;
+		const IPathGenerator*         generator;
+	};
+
+	std::vector<Route> _routes;
+	double             _startJitterInSeconds;
+	double             _speedJitter;
+	double             _gpsNoiseInMeter;
+
+public:
+	FleetSimulator();
+
+	/**
+	 * The vehicles take the routes in turn, generator has to live until Run returns
+	 */
+	void AddRoute(const osmscout::RoutePointsRef& points,
+		const osmscout::RouteDescriptionRef& description,
+		const IPathGenerator& generator);
+	/**
+	 * Start times spread over startJitterInSeconds, speeds scaled by a factor in 1 +- speedJitter
+	 * and every position moved by a normal distributed error with a sigma of gpsNoiseInMeter
+	 */
+	void SetJitter(double startJitterInSeconds, double speedJitter, double gpsNoiseInMeter);
+	/**
+	 * Drive vehicleCount vehicles on threadCount threads and print fixes per second
+	 * and the latency of every vehicle
+	 */
+	void Run(const osmscout::DatabaseRef& database, size_t vehicleCount, size_t threadCount);
+};
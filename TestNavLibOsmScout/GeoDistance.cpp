@@ -0,0 +1,265 @@
+#include "GeoDistance.h"
+#include <cmath>
+#include <osmscout/util/Geometry.h>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define GEODISTANCE_AVX2 1
+#define GEODISTANCE_AVX2_TARGET __attribute__((target("avx2")))
+#elif defined(_MSC_VER) && defined(__AVX2__)
+#include <immintrin.h>
+#define GEODISTANCE_AVX2 1
+#define GEODISTANCE_AVX2_TARGET
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define GEODISTANCE_NEON 1
+#endif
+
+//WGS-84
+static const double EquatorRadius = 6378.137; //km
+static const double Eccentricity2 = 6.69437999014e-3;
+static const double DegreeToRad = M_PI / 180.0;
+
+//Relative error of the approximation against Vincenty is below base + square * km^2 up to
+//LongDistance and 85 degree latitude, measured 1.4e-7 * km^2 at worst
+static const double ToleranceBase = 2e-5;
+static const double ToleranceSquare = 2e-7;
+//Farther than this every point is measured exactly
+static const double LongDistance = 250.0;
+//Points per pass of the pre-filter, on the stack
+static const size_t BlockSize = 256;
+
+//Taylor series, |x| <= pi/2 for latitudes, error below 1e-8
+static const double Cos2 = -1.0 / 2;
+static const double Cos4 = 1.0 / 24;
+static const double Cos6 = -1.0 / 720;
+static const double Cos8 = 1.0 / 40320;
+static const double Cos10 = -1.0 / 3628800;
+static const double Cos12 = 1.0 / 479001600;
+
+static inline double LocalDistance(double lat1, double lon1, double lat2, double lon2) {
+	const auto dLat = lat2 - lat1;
+	auto dLon = lon2 - lon1;
+	dLon -= 360.0 * std::nearbyint(dLon / 360.0);
+
+	const auto phi = (lat1 + lat2) * (0.5 * DegreeToRad);
+	const auto x2 = phi * phi;
+	const auto c = 1.0 + x2 * (Cos2 + x2 * (Cos4 + x2 * (Cos6 + x2 * (Cos8 + x2 * (Cos10 + x2 * Cos12)))));
+	const auto s2 = 1.0 - c * c;
+	const auto w = 1.0 / std::sqrt(1.0 - Eccentricity2 * s2);
+
+	//Meridian and prime vertical radius of curvature
+	const auto m = EquatorRadius * (1.0 - Eccentricity2) * w * w * w;
+	const auto n = EquatorRadius * w;
+	const auto dy = m * dLat * DegreeToRad;
+	const auto dx = n * c * dLon * DegreeToRad;
+	return std::sqrt(dx * dx + dy * dy);
+}
+
+//strideA 0 measures every point of B against the first point of A
+typedef void (*DistanceKernel)(const double* latsA, const double* lonsA, size_t strideA,
+	const double* latsB, const double* lonsB, size_t count, double* distances);
+
+static void ScalarKernel(const double* latsA, const double* lonsA, size_t strideA,
+	const double* latsB, const double* lonsB, size_t count, double* distances) {
+	for (size_t i = 0; i < count; i++) {
+		distances[i] = LocalDistance(latsA[i * strideA], lonsA[i * strideA], latsB[i], lonsB[i]);
+	}
+}
+
+#ifdef GEODISTANCE_AVX2
+GEODISTANCE_AVX2_TARGET
+static void Avx2Kernel(const double* latsA, const double* lonsA, size_t strideA,
+	const double* latsB, const double* lonsB, size_t count, double* distances) {
+	const auto half = _mm256_set1_pd(0.5 * DegreeToRad);
+	const auto toRad = _mm256_set1_pd(DegreeToRad);
+	const auto full = _mm256_set1_pd(360.0);
+	const auto invFull = _mm256_set1_pd(1.0 / 360.0);
+	const auto one = _mm256_set1_pd(1.0);
+	const auto e2 = _mm256_set1_pd(Eccentricity2);
+	const auto radiusN = _mm256_set1_pd(EquatorRadius);
+	const auto radiusM = _mm256_set1_pd(EquatorRadius * (1.0 - Eccentricity2));
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		const auto latA = strideA == 0 ? _mm256_set1_pd(latsA[0]) : _mm256_loadu_pd(latsA + i);
+		const auto lonA = strideA == 0 ? _mm256_set1_pd(lonsA[0]) : _mm256_loadu_pd(lonsA + i);
+		const auto latB = _mm256_loadu_pd(latsB + i);
+		const auto lonB = _mm256_loadu_pd(lonsB + i);
+
+		const auto dLat = _mm256_sub_pd(latB, latA);
+		auto dLon = _mm256_sub_pd(lonB, lonA);
+		const auto turns = _mm256_round_pd(_mm256_mul_pd(dLon, invFull), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+		dLon = _mm256_sub_pd(dLon, _mm256_mul_pd(full, turns));
+
+		const auto phi = _mm256_mul_pd(_mm256_add_pd(latA, latB), half);
+		const auto x2 = _mm256_mul_pd(phi, phi);
+		auto c = _mm256_add_pd(_mm256_set1_pd(Cos10), _mm256_mul_pd(x2, _mm256_set1_pd(Cos12)));
+		c = _mm256_add_pd(_mm256_set1_pd(Cos8), _mm256_mul_pd(x2, c));
+		c = _mm256_add_pd(_mm256_set1_pd(Cos6), _mm256_mul_pd(x2, c));
+		c = _mm256_add_pd(_mm256_set1_pd(Cos4), _mm256_mul_pd(x2, c));
+		c = _mm256_add_pd(_mm256_set1_pd(Cos2), _mm256_mul_pd(x2, c));
+		c = _mm256_add_pd(one, _mm256_mul_pd(x2, c));
+
+		const auto s2 = _mm256_sub_pd(one, _mm256_mul_pd(c, c));
+		const auto w = _mm256_div_pd(one, _mm256_sqrt_pd(_mm256_sub_pd(one, _mm256_mul_pd(e2, s2))));
+		const auto m = _mm256_mul_pd(_mm256_mul_pd(radiusM, w), _mm256_mul_pd(w, w));
+		const auto n = _mm256_mul_pd(radiusN, w);
+
+		const auto dy = _mm256_mul_pd(m, _mm256_mul_pd(dLat, toRad));
+		const auto dx = _mm256_mul_pd(_mm256_mul_pd(n, c), _mm256_mul_pd(dLon, toRad));
+		_mm256_storeu_pd(distances + i, _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy))));
+	}
+	ScalarKernel(latsA + i * strideA, lonsA + i * strideA, strideA, latsB + i, lonsB + i, count - i, distances + i);
+}
+
+static bool HasAvx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+	return true;
+#else
+	return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+#endif
+
+#ifdef GEODISTANCE_NEON
+static void NeonKernel(const double* latsA, const double* lonsA, size_t strideA,
+	const double* latsB, const double* lonsB, size_t count, double* distances) {
+	const auto half = vdupq_n_f64(0.5 * DegreeToRad);
+	const auto toRad = vdupq_n_f64(DegreeToRad);
+	const auto full = vdupq_n_f64(360.0);
+	const auto invFull = vdupq_n_f64(1.0 / 360.0);
+	const auto one = vdupq_n_f64(1.0);
+	const auto e2 = vdupq_n_f64(Eccentricity2);
+	const auto radiusN = vdupq_n_f64(EquatorRadius);
+	const auto radiusM = vdupq_n_f64(EquatorRadius * (1.0 - Eccentricity2));
+
+	size_t i = 0;
+	for (; i + 2 <= count; i += 2) {
+		const auto latA = strideA == 0 ? vdupq_n_f64(latsA[0]) : vld1q_f64(latsA + i);
+		const auto lonA = strideA == 0 ? vdupq_n_f64(lonsA[0]) : vld1q_f64(lonsA + i);
+		const auto latB = vld1q_f64(latsB + i);
+		const auto lonB = vld1q_f64(lonsB + i);
+
+		const auto dLat = vsubq_f64(latB, latA);
+		auto dLon = vsubq_f64(lonB, lonA);
+		dLon = vsubq_f64(dLon, vmulq_f64(full, vrndnq_f64(vmulq_f64(dLon, invFull))));
+
+		const auto phi = vmulq_f64(vaddq_f64(latA, latB), half);
+		const auto x2 = vmulq_f64(phi, phi);
+		auto c = vaddq_f64(vdupq_n_f64(Cos10), vmulq_f64(x2, vdupq_n_f64(Cos12)));
+		c = vaddq_f64(vdupq_n_f64(Cos8), vmulq_f64(x2, c));
+		c = vaddq_f64(vdupq_n_f64(Cos6), vmulq_f64(x2, c));
+		c = vaddq_f64(vdupq_n_f64(Cos4), vmulq_f64(x2, c));
+		c = vaddq_f64(vdupq_n_f64(Cos2), vmulq_f64(x2, c));
+		c = vaddq_f64(one, vmulq_f64(x2, c));
+
+		const auto s2 = vsubq_f64(one, vmulq_f64(c, c));
+		const auto w = vdivq_f64(one, vsqrtq_f64(vsubq_f64(one, vmulq_f64(e2, s2))));
+		const auto m = vmulq_f64(vmulq_f64(radiusM, w), vmulq_f64(w, w));
+		const auto n = vmulq_f64(radiusN, w);
+
+		const auto dy = vmulq_f64(m, vmulq_f64(dLat, toRad));
+		const auto dx = vmulq_f64(vmulq_f64(n, c), vmulq_f64(dLon, toRad));
+		vst1q_f64(distances + i, vsqrtq_f64(vaddq_f64(vmulq_f64(dx, dx), vmulq_f64(dy, dy))));
+	}
+	ScalarKernel(latsA + i * strideA, lonsA + i * strideA, strideA, latsB + i, lonsB + i, count - i, distances + i);
+}
+#endif
+
+struct KernelChoice
+{
+	DistanceKernel kernel;
+	const char*    name;
+};
+
+static const KernelChoice& GetKernel() {
+	static const KernelChoice choice = []() {
+#ifdef GEODISTANCE_AVX2
+		if (HasAvx2()) return KernelChoice{ Avx2Kernel, "avx2" };
+#endif
+#ifdef GEODISTANCE_NEON
+		return KernelChoice{ NeonKernel, "neon" };
+#endif
+		return KernelChoice{ ScalarKernel, "scalar" };
+	}();
+	return choice;
+}
+
+void GeoDistance::Approximate(double lat, double lon, const double* lats, const double* lons, size_t count, double* distancesInKilometer) {
+	GetKernel().kernel(&lat, &lon, 0, lats, lons, count, distancesInKilometer);
+}
+
+void GeoDistance::Successive(const double* lats, const double* lons, size_t count, double* distancesInKilometer) {
+	if (count < 2) return;
+	GetKernel().kernel(lats, lons, 1, lats + 1, lons + 1, count - 1, distancesInKilometer);
+}
+
+bool GeoDistance::FindFarthest(const osmscout::GeoCoord& origin, const double* lats, const double* lons, size_t count,
+	double& farthestInKilometer, size_t& farthestIndex) {
+	auto found = false;
+	double approximate[BlockSize];
+	size_t candidates[BlockSize];
+	for (size_t begin = 0; begin < count; begin += BlockSize) {
+		const auto blockCount = count - begin < BlockSize ? count - begin : BlockSize;
+		Approximate(origin.GetLat(), origin.GetLon(), lats + begin, lons + begin, blockCount, approximate);
+
+		size_t maxIndex = 0;
+		for (size_t i = 1; i < blockCount; i++) {
+			if (approximate[i] > approximate[maxIndex]) maxIndex = i;
+		}
+		const auto maxApproximate = approximate[maxIndex];
+
+		//The exact distance is within approximate / (1 +- tolerance), only points that can be the farthest are measured
+		auto reach = maxApproximate > farthestInKilometer ? maxApproximate : farthestInKilometer;
+		reach *= 1.05;
+		const auto tolerance = ToleranceBase + ToleranceSquare * reach * reach;
+		auto threshold = maxApproximate * (1.0 - tolerance) / (1.0 + tolerance);
+		if (maxApproximate > LongDistance) {
+			threshold = 0.0;
+		}
+		if (farthestInKilometer * (1.0 - tolerance) > threshold) {
+			threshold = farthestInKilometer * (1.0 - tolerance);
+		}
+
+		size_t candidateCount = 0;
+		for (size_t i = 0; i < blockCount; i++) {
+			if (approximate[i] >= threshold) candidates[candidateCount++] = i;
+		}
+		if (candidateCount == 0) continue;
+
+		//The best guess first, then most of the others fall below the new threshold
+		auto blockBest = farthestInKilometer;
+		size_t blockBestIndex = blockCount;
+		auto Measure = [&](size_t i) {
+			const osmscout::GeoCoord pos(lats[begin + i], lons[begin + i]);
+			const auto distanceInKilometer = osmscout::GetEllipsoidalDistance(origin, pos).As<osmscout::Kilometer>();
+			//Equal distance, the first point wins
+			if (distanceInKilometer > blockBest || (distanceInKilometer == blockBest && i < blockBestIndex && blockBestIndex < blockCount)) {
+				blockBest = distanceInKilometer;
+				blockBestIndex = i;
+			}
+		};
+		if (approximate[maxIndex] >= threshold) {
+			Measure(maxIndex);
+		}
+		for (size_t c = 0; c < candidateCount; c++) {
+			const auto i = candidates[c];
+			if (i == maxIndex || approximate[i] < blockBest * (1.0 - tolerance)) continue;
+			Measure(i);
+		}
+
+		if (blockBestIndex < blockCount) {
+			farthestInKilometer = blockBest;
+			farthestIndex = begin + blockBestIndex;
+			found = true;
+		}
+	}
+	return found;
+}
+
+const char* GeoDistance::GetKernelName() {
+	return GetKernel().name;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <osmscout/GeoCoord.h>
+
+/**
+ * Distances on contiguous lat/lon arrays in degree, with AVX2 or NEON if the CPU has it.
+ *
+ * The approximation works in the tangent plane with the WGS-84 radii of the mean latitude.
+ * Up to some kilometers its relative error against GetEllipsoidalDistance is below 2e-5 + 2e-7 * km^2, for longer distances
+ * it is only a pre-filter and the candidates are refined with GetEllipsoidalDistance.
+ */
+class GeoDistance
+{
+public:
+	/**
+	 * Distance from lat/lon to every point
+	 */
+	static void Approximate(double lat, double lon, const double* lats, const double* lons, size_t count, double* distancesInKilometer);
+	/**
+	 * Distance from every point to the next one, count - 1 results
+	 */
+	static void Successive(const double* lats, const double* lons, size_t count, double* distancesInKilometer);
+	/**
+	 * Look for a point that is farther away from origin than farthestInKilometer, only the candidates
+	 * of the approximation are measured with GetEllipsoidalDistance. The first of equal distant points wins.
+	 *
+	 * @return true if farthestInKilometer and farthestIndex got a new point
+	 */
+	static bool FindFarthest(const osmscout::GeoCoord& origin, const double* lats, const double* lons, size_t count,
+		double& farthestInKilometer, size_t& farthestIndex);
+	/**
+	 * "avx2", "neon" or "scalar"
+	 */
+	static const char* GetKernelName();
+};
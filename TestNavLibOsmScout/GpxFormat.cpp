@@ -0,0 +1,154 @@
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include "GpxFormat.h"
+
+static const double PowersOfTen[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12
+};
+
+//Upper bounds of the decimal exponents -4 to 7
+static const double ExponentBounds[] = {
+	1e-3, 1e-2, 1e-1, 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8
+};
+
+static const uint64_t IntegerPowersOfTen[] = {
+	1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull,
+	1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull
+};
+
+//Significant digits of "%.8g"
+static const int Precision = 8;
+
+static char* Digits(char* out, uint64_t value)
+{
+	char buffer[20];
+	auto digit = buffer + sizeof(buffer);
+	do {
+		*--digit = static_cast<char>('0' + value % 10);
+		value /= 10;
+	} while (value > 0);
+	while (digit < buffer + sizeof(buffer)) {
+		*out++ = *digit++;
+	}
+	return out;
+}
+
+static char* TwoDigits(char* out, unsigned value)
+{
+	out[0] = static_cast<char>('0' + value / 10);
+	out[1] = static_cast<char>('0' + value % 10);
+	return out + 2;
+}
+
+static char* Fallback(char* out, double value)
+{
+	const auto length = std::snprintf(out, GpxFormat::MaxDoubleSize, "%.8g", value);
+	return out + (length > 0 ? length : 0);
+}
+
+char* GpxFormat::Double(char* out, double value)
+{
+	auto magnitude = std::fabs(value);
+
+	// "%.8g" is fixed notation from 1e-4 up to 1e8, outside (and for nan or inf) leave it to the C library
+	if (!(magnitude >= 1e-4 && magnitude < 1e8)) {
+		if (magnitude == 0.0) {
+			if (std::signbit(value)) *out++ = '-';
+			*out++ = '0';
+			return out;
+		}
+		return Fallback(out, value);
+	}
+
+	// Decimal exponent, magnitude is in [10^exponent, 10^(exponent + 1))
+	int exponent = -4;
+	while (magnitude >= ExponentBounds[exponent + 4]) {
+		exponent++;
+	}
+
+	auto decimals = Precision - 1 - exponent;
+	const auto scaled = magnitude * PowersOfTen[decimals];
+
+	// The product is off by up to half an ulp, so only the C library knows on which side of a tie the value is
+	if (std::fabs(scaled - std::floor(scaled) - 0.5) < 1e-6) {
+		return Fallback(out, value);
+	}
+
+	auto digits = static_cast<uint64_t>(scaled + 0.5);
+	if (digits >= IntegerPowersOfTen[Precision]) {
+		// Rounded up to the next power of ten, one decimal less
+		if (decimals == 0) {
+			return Fallback(out, value);
+		}
+		digits /= 10;
+		decimals--;
+	}
+
+	if (value < 0) {
+		*out++ = '-';
+	}
+
+	const auto divisor = IntegerPowersOfTen[decimals];
+	out = Digits(out, digits / divisor);
+
+	auto fraction = digits % divisor;
+	if (fraction == 0) {
+		return out;
+	}
+
+	// Without the trailing zeros
+	while (fraction % 10 == 0) {
+		fraction /= 10;
+		decimals--;
+	}
+	*out++ = '.';
+	for (auto place = decimals - 1; place >= 0; place--) {
+		*out++ = static_cast<char>('0' + fraction / IntegerPowersOfTen[place] % 10);
+	}
+	return out;
+}
+
+char* GpxFormat::Timestamp(char* out, const osmscout::Timestamp& timestamp)
+{
+	const auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(timestamp.time_since_epoch()).count();
+	auto days = milliseconds / 86400000;
+	auto millisecondOfDay = milliseconds % 86400000;
+	if (millisecondOfDay < 0) {
+		millisecondOfDay += 86400000;
+		days--;
+	}
+
+	// Civil date from the days since 1970-01-01, proleptic Gregorian calendar
+	days += 719468;
+	const auto era = (days >= 0 ? days : days - 146096) / 146097;
+	const auto dayOfEra = days - era * 146097;
+	const auto yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+	const auto dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+	const auto monthIndex = (5 * dayOfYear + 2) / 153;
+	const auto day = static_cast<unsigned>(dayOfYear - (153 * monthIndex + 2) / 5 + 1);
+	const auto month = static_cast<unsigned>(monthIndex < 10 ? monthIndex + 3 : monthIndex - 9);
+	const auto year = yearOfEra + era * 400 + (month <= 2 ? 1 : 0);
+
+	const auto secondOfDay = static_cast<unsigned>(millisecondOfDay / 1000);
+	const auto millisecond = static_cast<unsigned>(millisecondOfDay % 1000);
+
+	out = TwoDigits(out, static_cast<unsigned>(year / 100 % 100));
+	out = TwoDigits(out, static_cast<unsigned>(year % 100));
+	*out++ = '-';
+	out = TwoDigits(out, month);
+	*out++ = '-';
+	out = TwoDigits(out, day);
+	*out++ = 'T';
+	out = TwoDigits(out, secondOfDay / 3600);
+	*out++ = ':';
+	out = TwoDigits(out, secondOfDay / 60 % 60);
+	*out++ = ':';
+	out = TwoDigits(out, secondOfDay % 60);
+	*out++ = '.';
+	*out++ = static_cast<char>('0' + millisecond / 100);
+	out = TwoDigits(out, millisecond % 100);
+	*out++ = 'Z';
+	return out;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+#include <osmscout/GeoCoord.h>
+
+/**
+ * Number and time formatting for GPX without streams and locales, the caller
+ * provides the room and gets back the end of the text
+ */
+class GpxFormat
+{
+public:
+	static const size_t MaxDoubleSize = 32;
+	static const size_t TimestampSize = 24;
+
+	/**
+	 * Like "%.8g", coordinates and speeds are formatted by hand, the rest by snprintf
+	 */
+	static char* Double(char* out, double value);
+	/**
+	 * UTC as "2024-05-01T12:34:56.789Z"
+	 */
+	static char* Timestamp(char* out, const osmscout::Timestamp& timestamp);
+};
@@ -0,0 +1,116 @@
+#include "GpxWriter.h"
+#include "GpxFormat.h"
+
+bool GpxWriter::Open(const std::string& filename, size_t blockSize) {
+	Close();
+	if (!_writer.Open(filename, blockSize)) return false;
+
+	_writer.Write(R"(<?xml version="1.0" encoding="UTF-8" standalone="no" ?>)" "\n");
+	_writer.Write(R"(<gpx xmlns="http://www.topografix.com/GPX/1/1" creator="TestNavLibOsmScout" version="0.1" xmlns:xsi="http://www.w3.org/2001/XMLSchema-instance" xsi:schemaLocation="http://www.topografix.com/GPX/1/1 http://www.topografix.com/GPX/1/1/gpx.xsd">)" "\n");
+	return true;
+}
+
+bool GpxWriter::Close() {
+	if (!_writer.IsOpen()) return true;
+
+	_writer.Write("</gpx>\n");
+	return _writer.Close();
+}
+
+void GpxWriter::WriteDouble(double value) {
+	const auto buffer = _writer.Reserve(GpxFormat::MaxDoubleSize);
+	if (buffer == nullptr) return;
+	_writer.Commit(GpxFormat::Double(buffer, value) - buffer);
+}
+
+void GpxWriter::WriteEscaped(const std::string& text) {
+	if (text.find_first_of("&<>\"") == std::string::npos) {
+		_writer.Write(text);
+		return;
+	}
+	for (const auto c : text) {
+		switch (c) {
+		case '&':
+			_writer.Write("&amp;");
+			break;
+		case '<':
+			_writer.Write("&lt;");
+			break;
+		case '>':
+			_writer.Write("&gt;");
+			break;
+		case '"':
+			_writer.Write("&quot;");
+			break;
+		default:
+			_writer.Write(&c, 1);
+			break;
+		}
+	}
+}
+
+void GpxWriter::Waypoint(const osmscout::GeoCoord& coord, const std::string& name) {
+	if (!_writer.IsOpen()) return;
+
+	_writer.Write("\t<wpt lat=\"");
+	WriteDouble(coord.GetLat());
+	_writer.Write("\" lon=\"");
+	WriteDouble(coord.GetLon());
+	_writer.Write("\">\n\t\t<name>");
+	WriteEscaped(name);
+	_writer.Write("</name>\n\t\t<fix>2d</fix>\n\t</wpt>\n");
+}
+
+void GpxWriter::BeginRoute(const std::string& name) {
+	if (!_writer.IsOpen()) return;
+
+	_writer.Write("\t<rte>\n\t\t<name>");
+	WriteEscaped(name);
+	_writer.Write("</name>\n");
+}
+
+void GpxWriter::RoutePoint(double lat, double lon) {
+	if (!_writer.IsOpen()) return;
+
+	_writer.Write("\t\t\t<rtept lat=\"");
+	WriteDouble(lat);
+	_writer.Write("\" lon=\"");
+	WriteDouble(lon);
+	_writer.Write("\">\n\t\t\t</rtept>\n");
+}
+
+void GpxWriter::EndRoute() {
+	if (!_writer.IsOpen()) return;
+
+	_writer.Write("\t</rte>\n");
+}
+
+void GpxWriter::BeginTrack(const std::string& name) {
+	if (!_writer.IsOpen()) return;
+
+	_writer.Write("\t<trk>\n\t\t<name>");
+	WriteEscaped(name);
+	_writer.Write("</name>\n\t\t<number>1</number>\n\t\t<trkseg>\n");
+}
+
+void GpxWriter::TrackPoint(double lat, double lon, const osmscout::Timestamp& time, double speed) {
+	if (!_writer.IsOpen()) return;
+
+	_writer.Write("\t\t\t<trkpt lat=\"");
+	WriteDouble(lat);
+	_writer.Write("\" lon=\"");
+	WriteDouble(lon);
+	_writer.Write("\">\n\t\t\t\t<time>");
+	const auto buffer = _writer.Reserve(GpxFormat::TimestampSize);
+	if (buffer == nullptr) return;
+	_writer.Commit(GpxFormat::Timestamp(buffer, time) - buffer);
+	_writer.Write("</time>\n\t\t\t\t<speed>");
+	WriteDouble(speed);
+	_writer.Write("</speed>\n\t\t\t\t<fix>2d</fix>\n\t\t\t</trkpt>\n");
+}
+
+void GpxWriter::EndTrack() {
+	if (!_writer.IsOpen()) return;
+
+	_writer.Write("\t\t</trkseg>\n\t</trk>\n");
+}
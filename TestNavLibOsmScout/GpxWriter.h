@@ -0,0 +1,44 @@
+#pragma once
+#include <string>
+#include <osmscout/GeoCoord.h>
+#include "AsyncFileWriter.h"
+
+/**
+ * GPX output formatted by GpxFormat straight into the blocks of AsyncFileWriter,
+ * the file is written in the background
+ */
+class GpxWriter
+{
+	AsyncFileWriter _writer;
+
+	void WriteDouble(double value);
+	void WriteEscaped(const std::string& text);
+
+public:
+	/**
+	 * Create the file and write the header
+	 */
+	bool Open(const std::string& filename, size_t blockSize = AsyncFileWriter::DefaultBlockSize);
+	/**
+	 * Write the end of the document and wait for the file
+	 */
+	bool Close();
+	bool IsOpen() const
+	{
+		return _writer.IsOpen();
+	}
+
+	void Waypoint(const osmscout::GeoCoord& coord, const std::string& name);
+
+	void BeginRoute(const std::string& name);
+	void RoutePoint(double lat, double lon);
+	void EndRoute();
+
+	void BeginTrack(const std::string& name);
+	/**
+	 * @param speed
+	 *    m/s like GPX wants it
+	 */
+	void TrackPoint(double lat, double lon, const osmscout::Timestamp& time, double speed);
+	void EndTrack();
+};
@@ -1,5 +1,6 @@
 #pragma once
-#include <list>
+#include <cstdint>
+#include <vector>
 #include <osmscout/GeoCoord.h>
 #include <osmscout/AreaAreaIndex.h>
 
@@ -17,19 +18,194 @@ public:
 		osmscout::Timestamp time;
 		double              speed;
 		osmscout::GeoCoord  coord;
+		// Quality of the fix, 0 if the source doesn't know it
+		double              hdop;
+		uint32_t            satellites;
+		uint32_t            fixType;    // 1 no fix, 2 2D, 3 3D
+
+		Step()
+			: speed(0.0),
+			hdop(0.0),
+			satellites(0),
+			fixType(0)
+		{
+			// no code
+		}
 
 		Step(const osmscout::Timestamp& time,
 			double speed,
-			const osmscout::GeoCoord& coord)
+			const osmscout::GeoCoord& coord,
+			double hdop = 0.0,
+			uint32_t satellites = 0,
+			uint32_t fixType = 0)
 			: time(time),
 			speed(speed),
-			coord(coord)
+			coord(coord),
+			hdop(hdop),
+			satellites(satellites),
+			fixType(fixType)
 		{
 			// no code
 		}
 	};
 
+	/**
+	 * Steps stored column by column, every column is one contiguous array
+	 */
+	class StepTrack
+	{
+		std::vector<osmscout::Timestamp> _times;
+		std::vector<double>              _speeds;
+		std::vector<double>              _lats;
+		std::vector<double>              _lons;
+		std::vector<float>               _hdops;
+		std::vector<uint8_t>             _satellites;
+		std::vector<uint8_t>             _fixTypes;
+
+	public:
+		void reserve(size_t count)
+		{
+			_times.reserve(count);
+			_speeds.reserve(count);
+			_lats.reserve(count);
+			_lons.reserve(count);
+			_hdops.reserve(count);
+			_satellites.reserve(count);
+			_fixTypes.reserve(count);
+		}
+
+		void clear()
+		{
+			_times.clear();
+			_speeds.clear();
+			_lats.clear();
+			_lons.clear();
+			_hdops.clear();
+			_satellites.clear();
+			_fixTypes.clear();
+		}
+
+		size_t size() const
+		{
+			return _times.size();
+		}
+
+		bool empty() const
+		{
+			return _times.empty();
+		}
+
+		void emplace_back(const osmscout::Timestamp& time, double speed, const osmscout::GeoCoord& coord,
+			double hdop = 0.0, uint32_t satellites = 0, uint32_t fixType = 0)
+		{
+			_times.push_back(time);
+			_speeds.push_back(speed);
+			_lats.push_back(coord.GetLat());
+			_lons.push_back(coord.GetLon());
+			_hdops.push_back(static_cast<float>(hdop));
+			_satellites.push_back(static_cast<uint8_t>(satellites > UINT8_MAX ? UINT8_MAX : satellites));
+			_fixTypes.push_back(static_cast<uint8_t>(fixType > UINT8_MAX ? UINT8_MAX : fixType));
+		}
+
+		void push_back(const Step& step)
+		{
+			emplace_back(step.time, step.speed, step.coord, step.hdop, step.satellites, step.fixType);
+		}
+
+		void append(const StepTrack& other)
+		{
+			_times.insert(_times.end(), other._times.begin(), other._times.end());
+			_speeds.insert(_speeds.end(), other._speeds.begin(), other._speeds.end());
+			_lats.insert(_lats.end(), other._lats.begin(), other._lats.end());
+			_lons.insert(_lons.end(), other._lons.begin(), other._lons.end());
+			_hdops.insert(_hdops.end(), other._hdops.begin(), other._hdops.end());
+			_satellites.insert(_satellites.end(), other._satellites.begin(), other._satellites.end());
+			_fixTypes.insert(_fixTypes.end(), other._fixTypes.begin(), other._fixTypes.end());
+		}
+
+		Step operator[](size_t index) const
+		{
+			return Step(_times[index], _speeds[index], osmscout::GeoCoord(_lats[index], _lons[index]),
+				_hdops[index], _satellites[index], _fixTypes[index]);
+		}
+
+		Step front() const
+		{
+			return (*this)[0];
+		}
+
+		Step back() const
+		{
+			return (*this)[size() - 1];
+		}
+
+		const osmscout::Timestamp& time(size_t index) const
+		{
+			return _times[index];
+		}
+
+		double speed(size_t index) const
+		{
+			return _speeds[index];
+		}
+
+		osmscout::GeoCoord coord(size_t index) const
+		{
+			return osmscout::GeoCoord(_lats[index], _lons[index]);
+		}
+
+		double hdop(size_t index) const
+		{
+			return _hdops[index];
+		}
+
+		uint32_t satellites(size_t index) const
+		{
+			return _satellites[index];
+		}
+
+		uint32_t fixType(size_t index) const
+		{
+			return _fixTypes[index];
+		}
+
+		const std::vector<osmscout::Timestamp>& times() const
+		{
+			return _times;
+		}
+
+		const std::vector<double>& speeds() const
+		{
+			return _speeds;
+		}
+
+		const std::vector<double>& lats() const
+		{
+			return _lats;
+		}
+
+		const std::vector<double>& lons() const
+		{
+			return _lons;
+		}
+
+		const std::vector<float>& hdops() const
+		{
+			return _hdops;
+		}
+
+		const std::vector<uint8_t>& satellites() const
+		{
+			return _satellites;
+		}
+
+		const std::vector<uint8_t>& fixTypes() const
+		{
+			return _fixTypes;
+		}
+	};
+
 public:
-	std::list<Step> steps;
+	StepTrack steps;
 
 };
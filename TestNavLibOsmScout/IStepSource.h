@@ -0,0 +1,51 @@
+#pragma once
+#include <chrono>
+#include "IPathGenerator.h"
+
+/**
+ * Pull interface for steps, the consumer asks for one step after the other
+ * and the source never has to hold the whole track
+ */
+class IStepSource
+{
+public:
+	virtual ~IStepSource() = default;
+
+	/**
+	 * @return false if there are no more steps
+	 */
+	virtual bool NextStep(IPathGenerator::Step& step) = 0;
+
+	/**
+	 * When the data of the last step arrived, only live sources know this
+	 */
+	virtual bool GetArrivalTime(std::chrono::steady_clock::time_point& /*arrival*/) const
+	{
+		return false;
+	}
+};
+
+/**
+ * Steps of an already generated track
+ */
+class TrackStepSource : public IStepSource
+{
+	const IPathGenerator::StepTrack& _steps;
+	size_t                           _index;
+
+public:
+	explicit TrackStepSource(const IPathGenerator::StepTrack& steps)
+		: _steps(steps),
+		_index(0)
+	{
+		// no code
+	}
+
+	bool NextStep(IPathGenerator::Step& step) override
+	{
+		if (_index >= _steps.size()) return false;
+		step = _steps[_index];
+		_index++;
+		return true;
+	}
+};
@@ -0,0 +1,78 @@
+#include "LatencyHistogram.h"
+#include <algorithm>
+
+LatencyHistogram::LatencyHistogram():
+	_buckets(),
+	_count(0),
+	_sum(0),
+	_min(UINT64_MAX),
+	_max(0) {
+}
+
+void LatencyHistogram::Add(std::chrono::steady_clock::duration latency) {
+	const auto count = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+	const auto micros = static_cast<uint64_t>(count < 0 ? 0 : count);
+
+	//Bucket n holds [2^(n-1), 2^n) us, bucket 0 is below 1us
+	size_t bucket = 0;
+	for (auto value = micros; value > 0 && bucket < BucketCount - 1; value >>= 1) {
+		bucket++;
+	}
+	_buckets[bucket]++;
+	_count++;
+	_sum += micros;
+	_min = std::min(_min, micros);
+	_max = std::max(_max, micros);
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other) {
+	for (size_t bucket = 0; bucket < BucketCount; bucket++) {
+		_buckets[bucket] += other._buckets[bucket];
+	}
+	_count += other._count;
+	_sum += other._sum;
+	_min = std::min(_min, other._min);
+	_max = std::max(_max, other._max);
+}
+
+uint64_t LatencyHistogram::GetCount() const {
+	return _count;
+}
+
+uint64_t LatencyHistogram::GetMean() const {
+	return _count > 0 ? _sum / _count : 0;
+}
+
+uint64_t LatencyHistogram::GetMax() const {
+	return _max;
+}
+
+uint64_t LatencyHistogram::Percentile(double percent) const {
+	//Upper bound of the bucket the percentile falls into
+	const auto wanted = static_cast<uint64_t>(_count * percent / 100.0 + 0.5);
+	uint64_t seen = 0;
+	for (size_t bucket = 0; bucket < BucketCount; bucket++) {
+		seen += _buckets[bucket];
+		if (seen >= wanted && seen > 0) {
+			return std::min<uint64_t>(bucket == 0 ? 1 : uint64_t(1) << bucket, _max);
+		}
+	}
+	return _max;
+}
+
+void LatencyHistogram::Print(std::ostream& stream) const {
+	if (_count == 0) {
+		stream << "no latency samples" << std::endl;
+		return;
+	}
+
+	stream << "latency us: count " << _count << " min " << _min << " mean " << _sum / _count
+		<< " p50 <= " << Percentile(50) << " p90 <= " << Percentile(90) << " p99 <= " << Percentile(99)
+		<< " max " << _max << std::endl;
+	for (size_t bucket = 0; bucket < BucketCount; bucket++) {
+		if (_buckets[bucket] == 0) continue;
+		const uint64_t from = bucket == 0 ? 0 : uint64_t(1) << (bucket - 1);
+		const uint64_t to = uint64_t(1) << bucket;
+		stream << "\t[" << from << ", " << to << ") " << _buckets[bucket] << std::endl;
+	}
+}
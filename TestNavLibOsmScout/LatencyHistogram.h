@@ -0,0 +1,33 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+/**
+ * Latency histogram with power of two buckets in microseconds
+ */
+class LatencyHistogram
+{
+	static const size_t BucketCount = 32;
+	uint64_t _buckets[BucketCount];
+	uint64_t _count;
+	uint64_t _sum;
+	uint64_t _min;
+	uint64_t _max;
+
+public:
+	LatencyHistogram();
+	void Add(std::chrono::steady_clock::duration latency);
+	/**
+	 * Add all samples of other, for totals over many histograms
+	 */
+	void Merge(const LatencyHistogram& other);
+	uint64_t GetCount() const;
+	uint64_t GetMean() const;
+	uint64_t GetMax() const;
+	/**
+	 * Upper bound in us of the bucket the percentile falls into
+	 */
+	uint64_t Percentile(double percent) const;
+	void Print(std::ostream& stream) const;
+};
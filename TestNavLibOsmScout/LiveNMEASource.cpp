@@ -0,0 +1,177 @@
+#include "LiveNMEASource.h"
+#include <cstring>
+#include <cerrno>
+#include "utils/easylogging++.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+//NMEA sentences are at most 82 characters, more without line end is garbage
+static const size_t BufferSize = 4096;
+
+LiveNMEASource::LiveNMEASource():
+	_fd(-1),
+	_buffer(BufferSize),
+	_begin(0),
+	_end(0),
+	_arrivalValid(false),
+	_hasPending(false) {
+}
+
+LiveNMEASource::~LiveNMEASource() {
+	Close();
+}
+
+#ifdef _WIN32
+bool LiveNMEASource::Open(const std::string& device) {
+	LOG(ERROR) << "Live input is not supported on windows " << device;
+	return false;
+}
+
+void LiveNMEASource::Close() {
+}
+
+bool LiveNMEASource::ReadDevice() {
+	return false;
+}
+#else
+bool LiveNMEASource::Open(const std::string& device) {
+	Close();
+
+	_fd = open(device.c_str(), O_RDONLY | O_NONBLOCK | O_NOCTTY);
+	if (_fd < 0) {
+		LOG(ERROR) << "Can't open " << device << " " << std::strerror(errno);
+		return false;
+	}
+
+	if (isatty(_fd)) {
+		//Raw mode, the speed stays as configured for the port
+		termios options;
+		if (tcgetattr(_fd, &options) == 0) {
+			cfmakeraw(&options);
+			options.c_cflag |= CLOCAL | CREAD;
+			tcsetattr(_fd, TCSANOW, &options);
+		}
+	}
+
+	_begin = 0;
+	_end = 0;
+	_hasPending = false;
+	return true;
+}
+
+void LiveNMEASource::Close() {
+	if (_fd >= 0) {
+		close(_fd);
+		_fd = -1;
+	}
+}
+
+bool LiveNMEASource::ReadDevice() {
+	if (_fd < 0) return false;
+
+	//Keep the begin of an incomplete sentence
+	if (_begin > 0) {
+		std::memmove(_buffer.data(), _buffer.data() + _begin, _end - _begin);
+		_end -= _begin;
+		_begin = 0;
+	}
+	if (_end == _buffer.size()) {
+		LOG(WARNING) << "Line without end dropped";
+		_end = 0;
+	}
+
+	for (;;) {
+		pollfd request;
+		request.fd = _fd;
+		request.events = POLLIN;
+		request.revents = 0;
+		const auto result = poll(&request, 1, -1);
+		if (result < 0) {
+			if (errno == EINTR) continue;
+			LOG(ERROR) << "poll failed " << std::strerror(errno);
+			return false;
+		}
+
+		const auto count = read(_fd, _buffer.data() + _end, _buffer.size() - _end);
+		if (count > 0) {
+			_readTime = std::chrono::steady_clock::now();
+			_end += static_cast<size_t>(count);
+			return true;
+		}
+		if (count == 0) {
+			//Writer closed the fifo or pty
+			return false;
+		}
+		if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) continue;
+		//A pty reports EIO after the other side is closed
+		if (errno != EIO) {
+			LOG(ERROR) << "read failed " << std::strerror(errno);
+		}
+		return false;
+	}
+}
+#endif
+
+bool LiveNMEASource::DecodeBuffered(IPathGenerator::Step& step) {
+	while (_begin < _end) {
+		const auto begin = _buffer.data() + _begin;
+		const auto lineEnd = static_cast<const char*>(std::memchr(begin, '\n', _end - _begin));
+		if (lineEnd == nullptr) return false;
+
+		const auto length = static_cast<size_t>(lineEnd - begin);
+		_begin += length + 1;
+
+		if (!_decoder.Decode(begin, length)) continue;
+		if (_decoder.IsPositionValid() && _decoder.IsSpeedValid() && _decoder.IsTimestampValid()) {
+			step.time = _decoder.GetTimePoint();
+			step.speed = _decoder.GetSpeed();
+			step.coord = osmscout::GeoCoord(_decoder.GetLatitude(), _decoder.GetLongitude());
+			step.hdop = _decoder.IsHdopValid() ? _decoder.GetHdop() : 0.0;
+			step.satellites = _decoder.IsSatellitesInUseValid() ? _decoder.GetSatellitesInUse() : 0;
+			step.fixType = _decoder.GetFixType();
+			//Every complete line in the buffer came with the last read
+			_arrival = _readTime;
+			_arrivalValid = true;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool LiveNMEASource::PeekStep(IPathGenerator::Step& step) {
+	if (!_hasPending) {
+		if (!NextStep(_pending)) return false;
+		_hasPending = true;
+	}
+	step = _pending;
+	return true;
+}
+
+bool LiveNMEASource::NextStep(IPathGenerator::Step& step) {
+	if (_hasPending) {
+		//Waited for the route, the latency of this step says nothing
+		step = _pending;
+		_hasPending = false;
+		_arrivalValid = false;
+		return true;
+	}
+
+	do {
+		if (DecodeBuffered(step)) return true;
+	} while (ReadDevice());
+	return false;
+}
+
+bool LiveNMEASource::GetArrivalTime(std::chrono::steady_clock::time_point& arrival) const {
+	arrival = _arrival;
+	return _arrivalValid;
+}
+
+const NMEAChecksumStats& LiveNMEASource::GetChecksumStats() const {
+	return _decoder.GetChecksumStats();
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <chrono>
+#include <string>
+#include <vector>
+#include "IStepSource.h"
+#include "NMEADecoder.h"
+
+/**
+ * Steps from a GPS receiver on a serial port, pty or fifo. The device is read
+ * non blocking with poll, a step is delivered as soon as its RMC sentence is complete.
+ */
+class LiveNMEASource : public IStepSource
+{
+	int                                   _fd;
+	std::vector<char>                     _buffer;
+	size_t                                _begin;
+	size_t                                _end;
+	NMEADecoder                           _decoder;
+	std::chrono::steady_clock::time_point _readTime;
+	std::chrono::steady_clock::time_point _arrival;
+	bool                                  _arrivalValid;
+	IPathGenerator::Step                  _pending;
+	bool                                  _hasPending;
+
+	bool DecodeBuffered(IPathGenerator::Step& step);
+	bool ReadDevice();
+
+public:
+	LiveNMEASource();
+	~LiveNMEASource();
+	LiveNMEASource(const LiveNMEASource&) = delete;
+	LiveNMEASource& operator=(const LiveNMEASource&) = delete;
+
+	bool Open(const std::string& device);
+	void Close();
+	/**
+	 * Wait for the first step, NextStep delivers it again
+	 */
+	bool PeekStep(IPathGenerator::Step& step);
+	bool NextStep(IPathGenerator::Step& step) override;
+	bool GetArrivalTime(std::chrono::steady_clock::time_point& arrival) const override;
+	const NMEAChecksumStats& GetChecksumStats() const;
+};
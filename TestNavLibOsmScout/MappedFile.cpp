@@ -0,0 +1,119 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile():
+	_data(nullptr),
+	_size(0),
+	_open(false)
+#ifdef _WIN32
+	,_fileHandle(INVALID_HANDLE_VALUE),
+	_mappingHandle(nullptr)
+#endif
+{
+}
+
+MappedFile::~MappedFile() {
+	Close();
+}
+
+#ifdef _WIN32
+bool MappedFile::Open(const std::string& filename) {
+	Close();
+
+	_fileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (_fileHandle == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(_fileHandle, &size)) {
+		Close();
+		return false;
+	}
+	_size = static_cast<size_t>(size.QuadPart);
+	_open = true;
+	if (_size == 0) return true;
+
+	_mappingHandle = CreateFileMappingA(_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (_mappingHandle == nullptr) {
+		Close();
+		return false;
+	}
+	_data = static_cast<const char*>(MapViewOfFile(_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+	if (_data == nullptr) {
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::Close() {
+	if (_data != nullptr) UnmapViewOfFile(_data);
+	if (_mappingHandle != nullptr) CloseHandle(_mappingHandle);
+	if (_fileHandle != INVALID_HANDLE_VALUE) CloseHandle(_fileHandle);
+	_data = nullptr;
+	_mappingHandle = nullptr;
+	_fileHandle = INVALID_HANDLE_VALUE;
+	_size = 0;
+	_open = false;
+}
+#else
+bool MappedFile::Open(const std::string& filename) {
+	Close();
+
+	const auto fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0) return false;
+
+	struct stat info;
+	if (fstat(fd, &info) != 0) {
+		close(fd);
+		return false;
+	}
+	_size = static_cast<size_t>(info.st_size);
+	_open = true;
+	if (_size == 0) {
+		close(fd);
+		return true;
+	}
+
+	auto data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		Close();
+		return false;
+	}
+	//We read the log from begin to end
+	madvise(data, _size, MADV_SEQUENTIAL);
+	_data = static_cast<const char*>(data);
+	return true;
+}
+
+void MappedFile::Close() {
+	if (_data != nullptr) munmap(const_cast<char*>(_data), _size);
+	_data = nullptr;
+	_size = 0;
+	_open = false;
+}
+#endif
+
+bool MappedFile::IsOpen() const {
+	return _open;
+}
+
+const char* MappedFile::Data() const {
+	return _data;
+}
+
+size_t MappedFile::Size() const {
+	return _size;
+}
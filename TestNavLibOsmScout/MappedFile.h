@@ -0,0 +1,29 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+/**
+ * Read only memory mapping of a whole file
+ */
+class MappedFile
+{
+	const char* _data;
+	size_t      _size;
+	bool        _open;
+#ifdef _WIN32
+	void*       _fileHandle;
+	void*       _mappingHandle;
+#endif
+
+public:
+	MappedFile();
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool Open(const std::string& filename);
+	void Close();
+	bool IsOpen() const;
+	const char* Data() const;
+	size_t Size() const;
+};
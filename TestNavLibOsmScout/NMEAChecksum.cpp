@@ -0,0 +1,68 @@
+#include "NMEAChecksum.h"
+#include <cstring>
+
+static int HexValue(char c) {
+	if (c >= '0' && c <= '9') return c - '0';
+	if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+	if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+	return -1;
+}
+
+uint8_t NMEAChecksum::Compute(const char* begin, const char* end) {
+	//XOR is order free, so all words can be folded first and the bytes at the end
+	uint64_t accu = 0;
+	while (end - begin >= 8) {
+		uint64_t word;
+		std::memcpy(&word, begin, sizeof(word));
+		accu ^= word;
+		begin += 8;
+	}
+	accu ^= accu >> 32;
+	accu ^= accu >> 16;
+	accu ^= accu >> 8;
+
+	auto crc = static_cast<uint8_t>(accu);
+	while (begin < end) {
+		crc ^= static_cast<uint8_t>(*begin);
+		begin++;
+	}
+	return crc;
+}
+
+bool NMEAChecksum::Verify(const char* line, size_t length, NMEAChecksumStats& stats) {
+	while (length > 0 && (line[length - 1] == '\r' || line[length - 1] == '\n')) {
+		length--;
+	}
+
+	stats.checked++;
+	if (length < 4 || line[0] != '$' || line[length - 3] != '*') {
+		stats.missing++;
+		stats.rejected++;
+		return false;
+	}
+
+	const auto high = HexValue(line[length - 2]);
+	const auto low = HexValue(line[length - 1]);
+	if (high < 0 || low < 0 || Compute(line + 1, line + length - 3) != ((high << 4) | low)) {
+		stats.rejected++;
+		return false;
+	}
+	return true;
+}
+
+size_t NMEAChecksum::VerifyBuffer(const char* buffer, size_t length, NMEAChecksumStats& stats) {
+	size_t valid = 0;
+	const auto end = buffer + length;
+	while (buffer < end) {
+		auto lineEnd = static_cast<const char*>(std::memchr(buffer, '\n', end - buffer));
+		if (lineEnd == nullptr) lineEnd = end;
+
+		auto lineLength = static_cast<size_t>(lineEnd - buffer);
+		if (lineLength > 0 && buffer[lineLength - 1] == '\r') lineLength--;
+		if (lineLength > 0 && Verify(buffer, lineLength, stats)) {
+			valid++;
+		}
+		buffer = lineEnd < end ? lineEnd + 1 : end;
+	}
+	return valid;
+}
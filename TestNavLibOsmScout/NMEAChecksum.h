@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Counters for the checksum check, rejected / checked is the error rate of the receiver link
+ */
+struct NMEAChecksumStats
+{
+	uint64_t checked;
+	uint64_t rejected;
+	uint64_t missing;
+
+	NMEAChecksumStats()
+		: checked(0),
+		rejected(0),
+		missing(0)
+	{
+		// no code
+	}
+};
+
+class NMEAChecksum
+{
+public:
+	/**
+	 * XOR of all bytes in [begin, end), eight bytes per step
+	 */
+	static uint8_t Compute(const char* begin, const char* end);
+
+	/**
+	 * Check "$...*hh" the trailing "\r\n" is ignored.
+	 * Sentences without checksum count as missing and are rejected.
+	 */
+	static bool Verify(const char* line, size_t length, NMEAChecksumStats& stats);
+
+	/**
+	 * Check all '\n' separated sentences in the buffer, empty lines are skipped
+	 *
+	 * @return count of valid sentences
+	 */
+	static size_t VerifyBuffer(const char* buffer, size_t length, NMEAChecksumStats& stats);
+};
@@ -5,9 +5,10 @@
 #   define ELPP_CURR_FILE_PERFORMANCE_LOGGER_ID ELPP_DEFAULT_LOGGER
 #endif
 
+#include <cstring>
 #include "utils/easylogging++.h"
 #include "NMEADecoder.h"
-#include "Tokenizer.h"
+#include "NMEAFixBatch.h"
 
 //http://www.kowoma.de/gps/zusatzerklaerungen/NMEA.htm
 //http://aprs.gids.nl/nmea/
@@ -27,149 +28,283 @@
 #define KMPH    1.852       // kilometers-per-hour in one knot
 #define MPH     1.1507794   // miles-per-hour in one knot
 
+//Sentence type and talker packed into one integer, so Decode can switch on it
+static constexpr uint32_t SentenceId(char a, char b, char c) {
+	return (static_cast<uint32_t>(static_cast<unsigned char>(a)) << 16) |
+		(static_cast<uint32_t>(static_cast<unsigned char>(b)) << 8) |
+		static_cast<uint32_t>(static_cast<unsigned char>(c));
+}
+
+static constexpr uint32_t TalkerId(char a, char b) {
+	return (static_cast<uint32_t>(static_cast<unsigned char>(a)) << 8) |
+		static_cast<uint32_t>(static_cast<unsigned char>(b));
+}
+
+//Index into the satellites in view, -1 for talkers we don't know
+static int TalkerIndex(char a, char b) {
+	switch (TalkerId(a, b)) {
+	case TalkerId('G', 'P'): return 0; //GPS
+	case TalkerId('G', 'L'): return 1; //GLONASS
+	case TalkerId('G', 'A'): return 2; //Galileo
+	case TalkerId('G', 'B'):           //BeiDou
+	case TalkerId('B', 'D'): return 3;
+	case TalkerId('G', 'Q'):           //QZSS
+	case TalkerId('Q', 'Z'): return 4;
+	case TalkerId('G', 'I'): return 5; //NavIC
+	case TalkerId('G', 'N'): return 6; //combined solution of all systems
+	default: return -1;
+	}
+}
+
 NMEADecoder::NMEADecoder():
+	_fieldCount(0),
 	_geoLat(0),
 	_geoLon(0),
 	_speed(0),
 	_compass(-1),
 	_posValid(false),
+	_posDecoded(false),
 	_timestampValid(false),
 	_speedValid(false),
 	_compassValid(false),
 	_lastTimestamp(0), 
-	_lastTime(),
-	_satelliteOnline(false) {
+	_timeOfDay(0),
+	_timeOfDayValid(false),
+	_dayNumber(0),
+	_dateValid(false),
+	_fixComplete(false),
+	_satelliteOnline(false),
+	_hdop(0),
+	_pdop(0),
+	_vdop(0),
+	_hdopValid(false),
+	_dopValid(false),
+	_fixType(0),
+	_fixTypeValid(false),
+	_satellitesInUse(0),
+	_satellitesInUseValid(false),
+	_satellitesInView(),
+	_talker(0) {
 	el::Loggers::getLogger(ELPP_DEFAULT_LOGGER);
 }
 
 NMEADecoder::~NMEADecoder() {
 }
 
-void NMEADecoder::DecodeGPGGA() {
-    DecodeUtcTime(_data[1]);
+const NMEAField& NMEADecoder::Field(size_t index) const {
+	static const NMEAField empty;
+	if (index >= _fieldCount) return empty;
+	return _fields[index];
+}
+
+void NMEADecoder::DecodeGGA() {
+    DecodeUtcTime(Field(1));
     //Global positioning system fixed data
     //$GPGGA,191410,4735.5634,N,00739.3538,E,1,04,4.4,351.5,M,48.0,M,,*45
-    if (std::stoi(_data[6]) > 0) {
-        DecodeLat(_data[3], _data[2]);
-        DecodeLon(_data[5], _data[4]);
-        _posValid = true;
+    uint32_t quality = 0;
+    if (Field(6).ToUnsigned(quality) && quality > 0) {
+        if (DecodeLat(Field(3), Field(2)) && DecodeLon(Field(5), Field(4))) {
+            _posValid = true;
+            _posDecoded = true;
+        }
+        uint32_t satellites;
+        if (Field(7).ToUnsigned(satellites)) {
+            _satellitesInUse = satellites;
+            _satellitesInUseValid = true;
+        }
+        double hdop;
+        if (Field(8).ToDouble(hdop)) {
+            _hdop = hdop;
+            _hdopValid = true;
+        }
         _satelliteOnline = true;
     } else {
         _satelliteOnline = false;
     }
 }
 
-void NMEADecoder::DecodeGPGSA() {
-    //GPS DOP and active satellites
+void NMEADecoder::DecodeGSA() {
+    //GNSS DOP and active satellites
+    //$GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1*39
+    uint32_t fixType;
+    if (Field(2).ToUnsigned(fixType)) {
+        _fixType = fixType;
+        _fixTypeValid = true;
+    }
+    double pdop;
+    double hdop;
+    double vdop;
+    if (Field(15).ToDouble(pdop) && Field(16).ToDouble(hdop) && Field(17).ToDouble(vdop)) {
+        _pdop = pdop;
+        _hdop = hdop;
+        _vdop = vdop;
+        _hdopValid = true;
+        _dopValid = true;
+    }
 }
 
-void NMEADecoder::DecodeGPGSV() {
-    //Satellites in view
+void NMEADecoder::DecodeGSV() {
+    //Satellites in view, one sentence per system and up to four satellites
+    //$GPGSV,3,1,11,03,03,111,00,04,15,270,00,06,01,010,00,13,06,292,00*74
+    uint32_t inView;
+    if (_talker < TalkerCount && Field(3).ToUnsigned(inView)) {
+        _satellitesInView[_talker] = inView;
+    }
+}
+
+void NMEADecoder::DecodeVTG() {
+    //Course over ground and ground speed
+    //$GPVTG,054.7,T,034.4,M,005.5,N,010.2,K,A*25
+    double value;
+    if (Field(1).ToDouble(value)) {
+        _compassValid = true;
+        _compass = value;
+    }
+    if (Field(7).ToDouble(value)) {
+        _speedValid = true;
+        _speed = value;
+    } else if (Field(5).ToDouble(value)) {
+        _speedValid = true;
+        _speed = value * KMPH;
+    }
 }
 
-void NMEADecoder::DecodeGPGLL() {
+void NMEADecoder::DecodeGLL() {
     //Geographic Position - Latitude/Longitude
     //$GPGLL,5024.6102,N,00921.8833,E,183242.000,A,A*5B
-    if (_data[6] == "A") {
-        DecodeLat(_data[2], _data[1]);
-        DecodeLon(_data[4], _data[3]);
-        DecodeUtcTime(_data[5]);
-        _posValid = true;
+    if (Field(6).Equals("A")) {
+        if (DecodeLat(Field(2), Field(1)) && DecodeLon(Field(4), Field(3))) {
+            _posValid = true;
+            _posDecoded = true;
+        }
+        DecodeUtcTime(Field(5));
         _satelliteOnline = true;
     } else {
         _satelliteOnline = false;
     }
 }
 
-void NMEADecoder::DecodeUtcTime(const std::string& time) {
-	//without seperator vs2015 can't decode the Time MS Bug ?
-	//Todo Corrent this we need two thinks an TimeStamp in local time and the di form last position update on linux and windows with micro sekonds
-	static const std::string dateTimeFormat{ "%H:%M:%S" };
-	auto timeLocal = time;
-	const auto j = timeLocal.find_first_of('.');
-	if (std::string::npos != j)
-	{
-		timeLocal = timeLocal.substr(0,j);
+bool NMEADecoder::DecodeUtcTime(const NMEAField& time) {
+	//hhmmss or hhmmss.sss
+	uint32_t hour;
+	uint32_t minute;
+	uint32_t second;
+	if (!time.Sub(0, 2).ToUnsigned(hour) ||
+		!time.Sub(2, 2).ToUnsigned(minute) ||
+		!time.Sub(4, 2).ToUnsigned(second) ||
+		hour > 23 || minute > 59 || second > 60) {
+		LOG(WARNING) << "Time convert Failed";
+		return false;
 	}
-	timeLocal = timeLocal.substr(0, 2) + ":" + timeLocal.substr(2);
-	timeLocal = timeLocal.substr(0, 5) + ":" + timeLocal.substr(5);
-	std::istringstream input(timeLocal);
-	input.imbue(std::locale(setlocale(LC_ALL, nullptr)));
-	input >> std::get_time(&_lastTime, dateTimeFormat.c_str());
-	if(input.fail()) {
-		LOG(WARNING) << "Date convert Failed";
-		return;
+
+	uint32_t milliSecond = 0;
+	if (time.size > 7 && time.data[6] == '.') {
+		//Only the first three digits are relevant
+		uint32_t scale = 100;
+		for (size_t i = 7; i < time.size && scale > 0; i++) {
+			const auto digit = static_cast<uint32_t>(time.data[i] - '0');
+			if (digit > 9) break;
+			milliSecond += digit * scale;
+			scale /= 10;
+		}
 	}
+
+	const auto timeOfDay = ((hour * 60 + minute) * 60 + second) * 1000 + milliSecond;
+	if (_timeOfDayValid && _dateValid && _timeOfDay > timeOfDay + 12 * 60 * 60 * 1000) {
+		//Midnight the date from the last RMC is one day old
+		_dayNumber++;
+	}
+	_timeOfDay = timeOfDay;
+	_timeOfDayValid = true;
+	return true;
 }
 
-void NMEADecoder::DecodeLat(const std::string& richtung, const std::string& value) {
-	_geoLat = std::stoi(value.substr(0, 2));
-	double nMinuten = std::stof(value.substr(2));
-	nMinuten = nMinuten / 60;
-	_geoLat += nMinuten;
-	if(richtung == "S") {
+bool NMEADecoder::DecodeLat(const NMEAField& richtung, const NMEAField& value) {
+	//ddmm.mmmm
+	int32_t lat;
+	if (!value.ToDegreesE7(2, lat) || lat > 900000000) {
+		return false;
+	}
+	if(richtung.Equals("S")) {
 		//Andere Seite WeltKugel
-		_geoLat = -_geoLat;
+		lat = -lat;
 	}
+	_geoLat = lat;
+	return true;
 }
 
-void NMEADecoder::DecodeLon(const std::string& richtung, const std::string& value) {
-	_geoLon = std::stoi(value.substr(0, 3));
-	double nMinuten = std::stof(value.substr(3));
-	nMinuten = nMinuten / 60;
-	_geoLon += nMinuten;
-	if (richtung == "W") {
+bool NMEADecoder::DecodeLon(const NMEAField& richtung, const NMEAField& value) {
+	//dddmm.mmmm
+	int32_t lon;
+	if (!value.ToDegreesE7(3, lon) || lon > 1800000000) {
+		return false;
+	}
+	if (richtung.Equals("W")) {
 		//Andere Seite WeltKugel
-		_geoLon = -_geoLon;
+		lon = -lon;
 	}
+	_geoLon = lon;
+	return true;
 }
 
-void NMEADecoder::DecodeDate(const std::string& dateString) {
-	static const std::string dateTimeFormat{ "%d.%m.%Y" };
-	auto dateLocal = dateString;
-	dateLocal = dateLocal.substr(0, 2) + "." + dateLocal.substr(2);
-	dateLocal = dateLocal.substr(0, 5) + ".20" + dateLocal.substr(5);
+static int32_t DaysFromCivil(int32_t year, uint32_t month, uint32_t day) {
+	//http://howardhinnant.github.io/date_algorithms.html
+	year -= month <= 2 ? 1 : 0;
+	const int32_t era = (year >= 0 ? year : year - 399) / 400;
+	const auto yearOfEra = static_cast<uint32_t>(year - era * 400);
+	const auto dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+	const auto dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+	return era * 146097 + static_cast<int32_t>(dayOfEra) - 719468;
+}
 
-	std::tm dt{};
-	std::istringstream input(dateLocal);
-	input.imbue(std::locale(setlocale(LC_ALL, nullptr)));
-	input >> std::get_time(&dt, dateTimeFormat.c_str());
-	if (input.fail()) {
+bool NMEADecoder::DecodeDate(const NMEAField& dateString) {
+	//ddmmyy
+	uint32_t day;
+	uint32_t month;
+	uint32_t year;
+	if (!dateString.Sub(0, 2).ToUnsigned(day) ||
+		!dateString.Sub(2, 2).ToUnsigned(month) ||
+		!dateString.Sub(4, 2).ToUnsigned(year) ||
+		day < 1 || day > 31 || month < 1 || month > 12) {
 		LOG(WARNING) << "Date convert Failed";
-		return;
+		return false;
 	}
 
-	dt.tm_hour = _lastTime.tm_hour;
-	dt.tm_sec = _lastTime.tm_sec;
-	dt.tm_min = _lastTime.tm_min;
-
-	_lastTimestamp = std::mktime(&dt);
-	_timestampValid = true;
+	_dayNumber = DaysFromCivil(2000 + static_cast<int32_t>(year), month, day);
+	_dateValid = true;
+	return true;
 }
 
-void NMEADecoder::DecodeGPRMC() {
+void NMEADecoder::DecodeRMC() {
 	//Recommended minimum specific GNSS data
-	DecodeUtcTime(_data[1]);
-	if(_data[2] == "A") {
+	//$GPRMC,183242.000,A,5024.6102,N,00921.8833,E,0.00,61.16,010519,,,A*6B
+	const auto timeValid = DecodeUtcTime(Field(1));
+	if(Field(2).Equals("A")) {
 		//V Ungültig
-		DecodeLat(_data[4], _data[3]);
-		DecodeLon(_data[6], _data[5]);
-		_posValid = true;
-		if(_data.size() >= 8) {
-			if (_data[7].length() > 0) {
-				_speedValid = true;
-				_speed = std::stof(_data[7]) * KMPH; //convert Knoten to Km/h
-			}
-			if (_data[8].length() > 0) {
-				_compassValid = true;
-				_compass = std::stof(_data[8]); //Bewegungsrichtung in Grad
-			}
-            if(_data.size() >= 9){
-                if(!_data[9].empty()) {
-                    //Not all GPS send this
-					DecodeDate(_data[9]);
-                }
-            }
+		const auto posDecoded = DecodeLat(Field(4), Field(3)) && DecodeLon(Field(6), Field(5));
+		if (posDecoded) {
+			_posValid = true;
+			_posDecoded = true;
+		}
+		double value;
+		const auto speedDecoded = Field(7).ToDouble(value);
+		if (speedDecoded) {
+			_speedValid = true;
+			_speed = value * KMPH; //convert Knoten to Km/h
+		}
+		if (Field(8).ToDouble(value)) {
+			_compassValid = true;
+			_compass = value; //Bewegungsrichtung in Grad
+		}
+		auto dateDecoded = false;
+		if (!Field(9).Empty()) {
+			//Not all GPS send this, without the date of the last RMC is used
+			dateDecoded = DecodeDate(Field(9));
+		}
+		_fixComplete = timeValid && posDecoded && speedDecoded && dateDecoded;
+		if (timeValid && _dateValid) {
+			_lastTimestamp = static_cast<int64_t>(_dayNumber) * 24 * 60 * 60 * 1000 + _timeOfDay;
+			_timestampValid = true;
 		}
         _satelliteOnline = true;
 	} else {
@@ -177,36 +312,75 @@ void NMEADecoder::DecodeGPRMC() {
     }
 }
 
-bool NMEADecoder::CheckCRC() {
-	auto value = _data[_data.size() - 1];
-	return true;
+bool NMEADecoder::CheckCRC(const char* line, size_t length) {
+	return NMEAChecksum::Verify(line, length, _checksumStats);
+}
+
+const char* NMEADecoder::DecodeBatch(const char* begin, const char* end, NMEAFixBatch& batch) {
+	batch.Clear();
+	auto line = begin;
+	while (line < end && !batch.Full()) {
+		const auto lineFeed = static_cast<const char*>(std::memchr(line, '\n', end - line));
+		const auto lineEnd = lineFeed != nullptr ? lineFeed : end;
+		const auto decoded = Decode(line, lineEnd - line);
+		line = lineFeed != nullptr ? lineFeed + 1 : end;
+		if (!decoded || !_posDecoded) continue;
+
+		const auto valid = static_cast<uint8_t>(
+			(_speedValid ? NMEAFixBatch::SpeedValid : 0) |
+			(_timestampValid ? NMEAFixBatch::TimestampValid : 0) |
+			(_compassValid ? NMEAFixBatch::CompassValid : 0) |
+			(_hdopValid ? NMEAFixBatch::HdopValid : 0) |
+			(_satellitesInUseValid ? NMEAFixBatch::SatellitesValid : 0));
+		batch.Add(_lastTimestamp, _geoLat, _geoLon, _speed, _compass, _hdop, _satellitesInUse, _fixType, valid);
+	}
+	return line;
 }
 
 bool NMEADecoder::Decode(const std::string& line) {
+	return Decode(line.data(), line.size());
+}
+
+bool NMEADecoder::Decode(const char* line, size_t length) {
 	_timestampValid = false;
-	_data.clear();
-	Tokenizer tokenizer(line, ",*");
-	
-	while(tokenizer.NextToken()) {
-		_data.push_back(tokenizer.GetToken());
+	_fixComplete = false;
+	_posDecoded = false;
+	while (length > 0 && (line[length - 1] == '\r' || line[length - 1] == '\n')) {
+		length--;
 	}
-
-	if (_data.empty()) return false;
-	if (!CheckCRC()) return false;
-
-	//Todo Many more
-
-	if(_data[0] == "$GPGGA") {
-		DecodeGPGGA();
-	} else if (_data[0] == "$GPGSA") {
-		DecodeGPGSA();
-	} else if (_data[0] == "$GPGSV") {
-		DecodeGPGSV();
-	} else if (_data[0] == "$GPRMC") {
-		DecodeGPRMC();
-    } else if (_data[0] == "$GPGLL") {
-		DecodeGPGLL();
-	} else {
+	if (length == 0) return false;
+	if (!CheckCRC(line, length)) return false;
+
+	_fieldCount = NMEAField::Split(line, length, _fields, MaxFields);
+	if (_fieldCount == 0) return false;
+
+	//$ttsss, tt is the talker (GP, GN, GL, ...) sss the sentence
+	const auto& id = _fields[0];
+	if (id.size != 6 || id.data[0] != '$') return false;
+	const auto talker = TalkerIndex(id.data[1], id.data[2]);
+	if (talker < 0) return false;
+	_talker = static_cast<size_t>(talker);
+
+	switch (SentenceId(id.data[3], id.data[4], id.data[5])) {
+	case SentenceId('G', 'G', 'A'):
+		DecodeGGA();
+		break;
+	case SentenceId('G', 'S', 'A'):
+		DecodeGSA();
+		break;
+	case SentenceId('G', 'S', 'V'):
+		DecodeGSV();
+		break;
+	case SentenceId('R', 'M', 'C'):
+		DecodeRMC();
+		break;
+	case SentenceId('G', 'L', 'L'):
+		DecodeGLL();
+		break;
+	case SentenceId('V', 'T', 'G'):
+		DecodeVTG();
+		break;
+	default:
 		return false;
 	}
     
@@ -223,6 +397,10 @@ bool NMEADecoder::IsPositionValid() const {
 	return _posValid;
 }
 
+bool NMEADecoder::IsPositionDecoded() const {
+	return _posDecoded;
+}
+
 bool NMEADecoder::IsSpeedValid() const {
 	return _speedValid;
 }
@@ -236,10 +414,18 @@ bool NMEADecoder::IsTimestampValid() const {
 }
 
 double NMEADecoder::GetLatitude() const {
-	return _geoLat;
+	return _geoLat / 1e7;
 }
 
 double NMEADecoder::GetLongitude() const {
+	return _geoLon / 1e7;
+}
+
+int32_t NMEADecoder::GetLatitudeE7() const {
+	return _geoLat;
+}
+
+int32_t NMEADecoder::GetLongitudeE7() const {
 	return _geoLon;
 }
 
@@ -252,5 +438,70 @@ double NMEADecoder::GetCompass() const {
 }
 
 std::time_t NMEADecoder::GetTimestamp() const {
+	return static_cast<std::time_t>(_lastTimestamp / 1000);
+}
+
+int64_t NMEADecoder::GetTimestampMilliseconds() const {
 	return _lastTimestamp;
 }
+
+std::chrono::system_clock::time_point NMEADecoder::GetTimePoint() const {
+	return std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(
+		std::chrono::milliseconds(_lastTimestamp)));
+}
+
+bool NMEADecoder::IsFixComplete(uint8_t requiredQuality) const {
+	return _fixComplete && (GetQualityValid() & requiredQuality) == requiredQuality;
+}
+
+uint8_t NMEADecoder::GetQualityValid() const {
+	return static_cast<uint8_t>(
+		(_hdopValid ? QualityHdop : 0) |
+		(_satellitesInUseValid ? QualitySatellites : 0) |
+		(_fixTypeValid ? QualityFixType : 0));
+}
+
+bool NMEADecoder::IsHdopValid() const {
+	return _hdopValid;
+}
+
+bool NMEADecoder::IsDopValid() const {
+	return _dopValid;
+}
+
+double NMEADecoder::GetHdop() const {
+	return _hdop;
+}
+
+double NMEADecoder::GetPdop() const {
+	return _pdop;
+}
+
+double NMEADecoder::GetVdop() const {
+	return _vdop;
+}
+
+uint32_t NMEADecoder::GetFixType() const {
+	return _fixType;
+}
+
+bool NMEADecoder::IsSatellitesInUseValid() const {
+	return _satellitesInUseValid;
+}
+
+uint32_t NMEADecoder::GetSatellitesInUse() const {
+	return _satellitesInUse;
+}
+
+uint32_t NMEADecoder::GetSatellitesInView() const {
+	//GN is the combined solution, only used if no system sends its own
+	uint32_t count = 0;
+	for (size_t talker = 0; talker < TalkerCount - 1; talker++) {
+		count += _satellitesInView[talker];
+	}
+	return count > 0 ? count : _satellitesInView[TalkerCount - 1];
+}
+
+const NMEAChecksumStats& NMEADecoder::GetChecksumStats() const {
+	return _checksumStats;
+}
@@ -1,48 +1,120 @@
 #pragma once
 
-#include <iomanip>
 #include <chrono>
-#include <vector>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include "NMEAField.h"
+#include "NMEAChecksum.h"
+
+class NMEAFixBatch;
 
 class NMEADecoder
 {
-    std::vector <std::string> _data;
-    double _geoLat;
-    double _geoLon;
+    static const size_t MaxFields = 32;
+    NMEAField _fields[MaxFields];
+    size_t _fieldCount;
+    int32_t _geoLat; //1e-7 degree
+    int32_t _geoLon;
     double _speed;
     double _compass;
     bool _posValid;
+    bool _posDecoded; //the last sentence had a position
     bool _timestampValid;
     bool _speedValid;
     bool _compassValid;
-	std::time_t _lastTimestamp;
-	std::tm     _lastTime;
+	int64_t     _lastTimestamp; //ms since 1970 UTC
+	uint32_t    _timeOfDay;     //ms since midnight UTC
+	bool        _timeOfDayValid;
+	int32_t     _dayNumber;     //days since 1970-01-01
+	bool        _dateValid;
+	bool        _fixComplete;
     bool _satelliteOnline;
+    NMEAChecksumStats _checksumStats;
+    double _hdop;
+    double _pdop;
+    double _vdop;
+    bool _hdopValid;
+    bool _dopValid;
+    uint32_t _fixType; //GSA 1 no fix, 2 2D, 3 3D
+    bool _fixTypeValid;
+    uint32_t _satellitesInUse;
+    bool _satellitesInUseValid;
+    static const size_t TalkerCount = 7;
+    uint32_t _satellitesInView[TalkerCount];
+    size_t _talker;
     
-    void DecodeGPGGA();
-    void DecodeGPGSA();
-    void DecodeGPGSV();
-    void DecodeGPGLL();
-    void DecodeUtcTime(const std::string& time);
-    void DecodeLat(const std::string& richtung, const std::string& value);
-    void DecodeLon(const std::string& richtung, const std::string& value);
-	void DecodeDate(const std::string& dateString);
-    void DecodeGPRMC();
-    bool CheckCRC();
+    void DecodeGGA();
+    void DecodeGSA();
+    void DecodeGSV();
+    void DecodeGLL();
+    void DecodeVTG();
+    bool DecodeUtcTime(const NMEAField& time);
+    bool DecodeLat(const NMEAField& richtung, const NMEAField& value);
+    bool DecodeLon(const NMEAField& richtung, const NMEAField& value);
+	bool DecodeDate(const NMEAField& dateString);
+    void DecodeRMC();
+    bool CheckCRC(const char* line, size_t length);
+    const NMEAField& Field(size_t index) const;
     
 public:
     NMEADecoder();
     ~NMEADecoder();
 
     bool Decode(const std::string& line);
+    bool Decode(const char* line, size_t length);
+    /**
+     * Decode the lines of a buffer until its end or until the batch is full.
+     * The batch is cleared first, then gets one row for every sentence with a valid position (GGA, GLL, RMC).
+     *
+     * @return begin of the first line not decoded
+     */
+    const char* DecodeBatch(const char* begin, const char* end, NMEAFixBatch& batch);
 	bool IsPositionValid() const;
+	/**
+	 * The last decoded sentence had a valid position, IsPositionValid stays set after GSA, GSV or VTG too
+	 */
+	bool IsPositionDecoded() const;
 	bool IsSpeedValid() const;
 	bool IsCompassValid() const;
 	bool IsTimestampValid() const;
 	double GetLatitude() const;
 	double GetLongitude() const;
+	int32_t GetLatitudeE7() const;
+	int32_t GetLongitudeE7() const;
 	double GetSpeed() const;
 	double GetCompass() const;
 	std::time_t GetTimestamp() const;
+	int64_t GetTimestampMilliseconds() const;
+	std::chrono::system_clock::time_point GetTimePoint() const;
+	enum Quality : uint8_t
+	{
+		QualityHdop = 1,
+		QualitySatellites = 2,
+		QualityFixType = 4,
+		QualityAll = 7
+	};
+
+	/**
+	 * The last sentence was a RMC with time, date, position and speed, and the quality values of
+	 * requiredQuality were decoded by this decoder. After such a sentence the decoder state no longer
+	 * depends on the sentences before, a decoder started in the middle of a log gives the same results
+	 * from here on. Quality values the log doesn't send can be left out of requiredQuality.
+	 */
+	bool IsFixComplete(uint8_t requiredQuality = QualityAll) const;
+	/**
+	 * Quality values decoded since the start, the Quality flags
+	 */
+	uint8_t GetQualityValid() const;
+	bool IsHdopValid() const;
+	bool IsDopValid() const;
+	double GetHdop() const;
+	double GetPdop() const;
+	double GetVdop() const;
+	uint32_t GetFixType() const;
+	bool IsSatellitesInUseValid() const;
+	uint32_t GetSatellitesInUse() const;
+	uint32_t GetSatellitesInView() const;
+	const NMEAChecksumStats& GetChecksumStats() const;
 };
 
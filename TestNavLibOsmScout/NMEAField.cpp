@@ -0,0 +1,135 @@
+#include "NMEAField.h"
+#include <cstring>
+
+static const double Pow10Table[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+	1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18
+};
+
+bool NMEAField::Empty() const {
+	return size == 0;
+}
+
+bool NMEAField::Equals(const char* text) const {
+	const auto length = std::strlen(text);
+	return length == size && (size == 0 || std::memcmp(data, text, size) == 0);
+}
+
+NMEAField NMEAField::Sub(size_t offset, size_t count) const {
+	if (offset >= size) return NMEAField(data + size, 0);
+	if (count > size - offset) count = size - offset;
+	return NMEAField(data + offset, count);
+}
+
+bool NMEAField::ToUnsigned(uint32_t& value) const {
+	if (size == 0 || size > 9) return false;
+
+	uint32_t result = 0;
+	for (size_t i = 0; i < size; i++) {
+		const auto digit = static_cast<uint32_t>(data[i] - '0');
+		if (digit > 9) return false;
+		result = result * 10 + digit;
+	}
+	value = result;
+	return true;
+}
+
+bool NMEAField::ToDouble(double& value) const {
+	size_t pos = 0;
+	auto negative = false;
+	if (pos < size && (data[pos] == '-' || data[pos] == '+')) {
+		negative = data[pos] == '-';
+		pos++;
+	}
+
+	//Mantissa as integer and one division at the end, no rounding error for the digits a receiver sends
+	uint64_t mantissa = 0;
+	size_t digits = 0;
+	size_t fractionDigits = 0;
+	auto anyDigit = false;
+	auto inFraction = false;
+	for (; pos < size; pos++) {
+		const auto c = data[pos];
+		if (c == '.' && !inFraction) {
+			inFraction = true;
+			continue;
+		}
+		const auto digit = static_cast<uint32_t>(c - '0');
+		if (digit > 9) return false;
+		anyDigit = true;
+		if (digits >= 18 || fractionDigits >= 18) {
+			//More precision than a double can hold, the rest of the fraction is ignored
+			if (!inFraction) return false;
+			continue;
+		}
+		mantissa = mantissa * 10 + digit;
+		if (mantissa != 0) digits++;
+		if (inFraction) fractionDigits++;
+	}
+
+	if (!anyDigit) return false;
+
+	auto result = static_cast<double>(mantissa);
+	if (fractionDigits > 0) {
+		result /= Pow10Table[fractionDigits];
+	}
+	value = negative ? -result : result;
+	return true;
+}
+
+bool NMEAField::ToDegreesE7(size_t degreeDigits, int32_t& value) const {
+	//Degrees and whole minutes have a fixed width
+	const auto integerDigits = degreeDigits + 2;
+	if (size < integerDigits || (size > integerDigits && data[integerDigits] != '.')) return false;
+
+	uint32_t degree = 0;
+	for (size_t i = 0; i < degreeDigits; i++) {
+		const auto digit = static_cast<uint32_t>(data[i] - '0');
+		if (digit > 9) return false;
+		degree = degree * 10 + digit;
+	}
+
+	//Minutes in 1e-7, exact for every digit we keep
+	uint64_t minutes = 0;
+	for (size_t i = degreeDigits; i < integerDigits; i++) {
+		const auto digit = static_cast<uint32_t>(data[i] - '0');
+		if (digit > 9) return false;
+		minutes = minutes * 10 + digit;
+	}
+	size_t fractionDigits = 0;
+	for (size_t i = integerDigits + 1; i < size; i++) {
+		const auto digit = static_cast<uint32_t>(data[i] - '0');
+		if (digit > 9) return false;
+		if (fractionDigits < 7) {
+			minutes = minutes * 10 + digit;
+			fractionDigits++;
+		}
+	}
+	for (; fractionDigits < 7; fractionDigits++) {
+		minutes *= 10;
+	}
+
+	if (degree > 180 || minutes >= 600000000) return false;
+	value = static_cast<int32_t>(degree * 10000000 + (minutes + 30) / 60);
+	return true;
+}
+
+size_t NMEAField::Split(const char* line, size_t length, NMEAField* fields, size_t maxFields) {
+	while (length > 0 && (line[length - 1] == '\r' || line[length - 1] == '\n')) {
+		length--;
+	}
+	if (length == 0 || maxFields == 0) return 0;
+
+	size_t count = 0;
+	size_t start = 0;
+	for (size_t i = 0; i < length; i++) {
+		const auto c = line[i];
+		if (c == ',' || c == '*') {
+			if (count + 1 >= maxFields) return 0;
+			fields[count++] = NMEAField(line + start, i - start);
+			start = i + 1;
+		}
+	}
+	fields[count++] = NMEAField(line + start, length - start);
+	return count;
+}
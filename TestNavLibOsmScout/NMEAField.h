@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Non owning view on one field of a NMEA sentence.
+ * The view is only valid as long as the buffer of the sentence lives.
+ */
+struct NMEAField
+{
+	const char* data;
+	size_t      size;
+
+	NMEAField()
+		: data(nullptr),
+		size(0)
+	{
+		// no code
+	}
+
+	NMEAField(const char* data, size_t size)
+		: data(data),
+		size(size)
+	{
+		// no code
+	}
+
+	bool Empty() const;
+	bool Equals(const char* text) const;
+	NMEAField Sub(size_t offset, size_t count) const;
+
+	bool ToUnsigned(uint32_t& value) const;
+	bool ToDouble(double& value) const;
+	/**
+	 * NMEA angle (d)ddmm.mmmm as integer 1e-7 degree, finer than the minute digits receivers send.
+	 * Fraction digits past the seventh are ignored.
+	 */
+	bool ToDegreesE7(size_t degreeDigits, int32_t& value) const;
+
+	/**
+	 * Split a sentence at ',' and '*' without copying.
+	 * Trailing "\r\n" is ignored, the checksum is the last field.
+	 *
+	 * @return count of fields or 0 if the sentence has more than maxFields fields
+	 */
+	static size_t Split(const char* line, size_t length, NMEAField* fields, size_t maxFields);
+};
@@ -0,0 +1,152 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Fixes of many sentences column by column, filled by NMEADecoder::DecodeBatch.
+ * The columns are allocated once, a row is written for every sentence with a valid position.
+ * What else is valid says the bitmask of the row.
+ */
+class NMEAFixBatch
+{
+public:
+	static const size_t DefaultCapacity = 4096;
+
+	static const uint8_t SpeedValid = 1;
+	static const uint8_t TimestampValid = 2;
+	static const uint8_t CompassValid = 4;
+	static const uint8_t HdopValid = 8;
+	static const uint8_t SatellitesValid = 16;
+
+private:
+	size_t                _size;
+	std::vector<int64_t>  _times;      //ms since 1970 UTC
+	std::vector<int32_t>  _lats;       //1e-7 degree
+	std::vector<int32_t>  _lons;
+	std::vector<double>   _speeds;     //km/h
+	std::vector<float>    _compass;
+	std::vector<float>    _hdops;
+	std::vector<uint8_t>  _satellites;
+	std::vector<uint8_t>  _fixTypes;
+	std::vector<uint8_t>  _valid;
+
+	static size_t RowCount(size_t capacity)
+	{
+		return capacity > 0 ? capacity : 1;
+	}
+
+public:
+	/**
+	 * A capacity of 0 gives one row, an always full batch would never let DecodeBatch get past a line
+	 */
+	explicit NMEAFixBatch(size_t capacity = DefaultCapacity)
+		: _size(0),
+		_times(RowCount(capacity)),
+		_lats(RowCount(capacity)),
+		_lons(RowCount(capacity)),
+		_speeds(RowCount(capacity)),
+		_compass(RowCount(capacity)),
+		_hdops(RowCount(capacity)),
+		_satellites(RowCount(capacity)),
+		_fixTypes(RowCount(capacity)),
+		_valid(RowCount(capacity))
+	{
+		// no code
+	}
+
+	size_t Size() const
+	{
+		return _size;
+	}
+
+	size_t Capacity() const
+	{
+		return _valid.size();
+	}
+
+	bool Full() const
+	{
+		return _size == _valid.size();
+	}
+
+	void Clear()
+	{
+		_size = 0;
+	}
+
+	void Add(int64_t time, int32_t lat, int32_t lon, double speed, double compass,
+		double hdop, uint32_t satellites, uint32_t fixType, uint8_t valid)
+	{
+		const auto index = _size++;
+		_times[index] = time;
+		_lats[index] = lat;
+		_lons[index] = lon;
+		_speeds[index] = speed;
+		_compass[index] = static_cast<float>(compass);
+		_hdops[index] = static_cast<float>(hdop);
+		_satellites[index] = static_cast<uint8_t>(satellites > UINT8_MAX ? UINT8_MAX : satellites);
+		_fixTypes[index] = static_cast<uint8_t>(fixType > UINT8_MAX ? UINT8_MAX : fixType);
+		_valid[index] = valid;
+	}
+
+	bool IsValid(size_t index, uint8_t flags) const
+	{
+		return (_valid[index] & flags) == flags;
+	}
+
+	uint8_t Valid(size_t index) const
+	{
+		return _valid[index];
+	}
+
+	int64_t TimeMilliseconds(size_t index) const
+	{
+		return _times[index];
+	}
+
+	int32_t LatitudeE7(size_t index) const
+	{
+		return _lats[index];
+	}
+
+	int32_t LongitudeE7(size_t index) const
+	{
+		return _lons[index];
+	}
+
+	double Latitude(size_t index) const
+	{
+		return _lats[index] / 1e7;
+	}
+
+	double Longitude(size_t index) const
+	{
+		return _lons[index] / 1e7;
+	}
+
+	double Speed(size_t index) const
+	{
+		return _speeds[index];
+	}
+
+	double Compass(size_t index) const
+	{
+		return _compass[index];
+	}
+
+	double Hdop(size_t index) const
+	{
+		return _hdops[index];
+	}
+
+	uint32_t Satellites(size_t index) const
+	{
+		return _satellites[index];
+	}
+
+	uint32_t FixType(size_t index) const
+	{
+		return _fixTypes[index];
+	}
+};
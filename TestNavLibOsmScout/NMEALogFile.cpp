@@ -0,0 +1,46 @@
+#include "NMEALogFile.h"
+#include <cstring>
+
+NMEALineReader::NMEALineReader(const char* begin, const char* end):
+	_current(begin),
+	_end(end) {
+}
+
+bool NMEALineReader::Next(const char*& line, size_t& length) {
+	if (_current >= _end) return false;
+
+	auto lineEnd = static_cast<const char*>(std::memchr(_current, '\n', _end - _current));
+	if (lineEnd == nullptr) lineEnd = _end;
+
+	line = _current;
+	length = static_cast<size_t>(lineEnd - _current);
+	if (length > 0 && line[length - 1] == '\r') length--;
+
+	_current = lineEnd < _end ? lineEnd + 1 : _end;
+	return true;
+}
+
+const char* NMEALineReader::Position() const {
+	return _current;
+}
+
+bool NMEALogFile::Open(const std::string& filename) {
+	_filename = filename;
+	return _file.Open(filename);
+}
+
+const std::string& NMEALogFile::GetFilename() const {
+	return _filename;
+}
+
+const char* NMEALogFile::Data() const {
+	return _file.Data();
+}
+
+size_t NMEALogFile::Size() const {
+	return _file.Size();
+}
+
+NMEALineReader NMEALogFile::CreateReader() const {
+	return NMEALineReader(_file.Data(), _file.Data() + _file.Size());
+}
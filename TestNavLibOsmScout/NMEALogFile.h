@@ -0,0 +1,33 @@
+#pragma once
+#include <string>
+#include "MappedFile.h"
+
+/**
+ * Walks the lines of a buffer without copying, "\r\n" and "\n" are supported
+ */
+class NMEALineReader
+{
+	const char* _current;
+	const char* _end;
+
+public:
+	NMEALineReader(const char* begin, const char* end);
+	bool Next(const char*& line, size_t& length);
+	const char* Position() const;
+};
+
+/**
+ * A NMEA log mapped once into memory, every consumer creates its own reader
+ */
+class NMEALogFile
+{
+	MappedFile  _file;
+	std::string _filename;
+
+public:
+	bool Open(const std::string& filename);
+	const std::string& GetFilename() const;
+	const char* Data() const;
+	size_t Size() const;
+	NMEALineReader CreateReader() const;
+};
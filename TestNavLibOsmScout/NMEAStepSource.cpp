@@ -0,0 +1,44 @@
+#include "NMEAStepSource.h"
+
+NMEAStepSource::NMEAStepSource(const NMEALogFile& log):
+	_position(log.Data()),
+	_end(log.Data() + log.Size()),
+	_batch(BatchCapacity),
+	_next(0) {
+}
+
+bool NMEAStepSource::PeekStep(IPathGenerator::Step& step) {
+	if (!NextStep(step)) return false;
+
+	//The step stays in the batch until the next one is taken
+	_next--;
+	return true;
+}
+
+bool NMEAStepSource::NextStep(IPathGenerator::Step& step) {
+	for (;;) {
+		while (_next < _batch.Size()) {
+			const auto index = _next++;
+
+			//Same filter as PathGeneratorNMEA
+			if (_batch.IsValid(index, NMEAFixBatch::SpeedValid | NMEAFixBatch::TimestampValid)) {
+				step.time = osmscout::Timestamp(std::chrono::duration_cast<osmscout::Timestamp::duration>(
+					std::chrono::milliseconds(_batch.TimeMilliseconds(index))));
+				step.speed = _batch.Speed(index);
+				step.coord = osmscout::GeoCoord(_batch.Latitude(index), _batch.Longitude(index));
+				step.hdop = _batch.IsValid(index, NMEAFixBatch::HdopValid) ? _batch.Hdop(index) : 0.0;
+				step.satellites = _batch.IsValid(index, NMEAFixBatch::SatellitesValid) ? _batch.Satellites(index) : 0;
+				step.fixType = _batch.FixType(index);
+				return true;
+			}
+		}
+
+		if (_position >= _end) return false;
+		_position = _decoder.DecodeBatch(_position, _end, _batch);
+		_next = 0;
+	}
+}
+
+const NMEAChecksumStats& NMEAStepSource::GetChecksumStats() const {
+	return _decoder.GetChecksumStats();
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "IStepSource.h"
+#include "NMEADecoder.h"
+#include "NMEAFixBatch.h"
+#include "NMEALogFile.h"
+
+/**
+ * Decodes the log while the steps are pulled, only one batch of fixes is in memory
+ */
+class NMEAStepSource : public IStepSource
+{
+	static const size_t BatchCapacity = 1024;
+
+	const char*  _position;
+	const char*  _end;
+	NMEADecoder  _decoder;
+	NMEAFixBatch _batch;
+	size_t       _next;
+
+public:
+	explicit NMEAStepSource(const NMEALogFile& log);
+	/**
+	 * The first step without taking it, NextStep delivers it again
+	 */
+	bool PeekStep(IPathGenerator::Step& step);
+	bool NextStep(IPathGenerator::Step& step) override;
+	const NMEAChecksumStats& GetChecksumStats() const;
+};
@@ -7,10 +7,70 @@
  * @param maxSpeed
  *    Max speed to use if no explicit speed limit in given on a route segment
  */
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <limits>
+#include <vector>
 #include <osmscout/routing/Route.h>
-#include <osmscout/util/Geometry.h>
 #include "PathGenerator.h"
+#include "RouteTable.h"
+
+//Slowest speed in m/s the route aware mode drives, so it does not stall in front of the target
+static const double CrawlSpeed = 0.5;
+
+/**
+ * Fastest speed in km/h to pass the node, from the turn and junction descriptions
+ */
+static double NodeSpeed(const osmscout::RouteDescription::Node& node, const PathGenerator::DrivingModel& model)
+{
+	auto speed = std::numeric_limits<double>::max();
+
+	if (node.HasDescription(osmscout::RouteDescription::ROUNDABOUT_ENTER_DESC) ||
+		node.HasDescription(osmscout::RouteDescription::ROUNDABOUT_LEAVE_DESC)) {
+		speed = model.roundaboutSpeed;
+	}
+
+	osmscout::RouteDescription::DirectionDescriptionRef directionDescription = std::dynamic_pointer_cast<osmscout::RouteDescription::DirectionDescription>(node.GetDescription(osmscout::RouteDescription::DIRECTION_DESC));
+	osmscout::RouteDescription::CrossingWaysDescriptionRef crossingWaysDescription = std::dynamic_pointer_cast<osmscout::RouteDescription::CrossingWaysDescription>(node.GetDescription(osmscout::RouteDescription::CROSSING_WAYS_DESC));
+
+	if (directionDescription) {
+		switch (directionDescription->GetCurve()) {
+		case osmscout::RouteDescription::DirectionDescription::sharpLeft:
+		case osmscout::RouteDescription::DirectionDescription::sharpRight:
+			speed = std::min(speed, model.sharpTurnSpeed);
+			break;
+		case osmscout::RouteDescription::DirectionDescription::left:
+		case osmscout::RouteDescription::DirectionDescription::right:
+			speed = std::min(speed, model.turnSpeed);
+			break;
+		case osmscout::RouteDescription::DirectionDescription::slightlyLeft:
+		case osmscout::RouteDescription::DirectionDescription::slightlyRight:
+			// A slight bend of the road is taken at full speed, a slight turn into another street is not
+			if (node.HasDescription(osmscout::RouteDescription::TURN_DESC) ||
+				(crossingWaysDescription && crossingWaysDescription->GetExitCount() > 2)) {
+				speed = std::min(speed, model.junctionSpeed);
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	return speed;
+}
+
+PathGenerator::DrivingModel::DrivingModel()
+	: tickRate(10.0),
+	acceleration(2.0),
+	deceleration(3.0),
+	sharpTurnSpeed(15.0),
+	turnSpeed(25.0),
+	junctionSpeed(40.0),
+	roundaboutSpeed(25.0)
+{
+	// no code
+}
 
 PathGenerator::PathGenerator(const osmscout::RouteDescription& description,
 	double maxSpeed)
@@ -19,14 +79,12 @@ PathGenerator::PathGenerator(const osmscout::RouteDescription& description,
 	double             totalTime = 0.0;
 	double             restTime = 0.0;
 	auto               currentNode = description.Nodes().begin();
-	auto               nextNode = currentNode;
-	osmscout::GeoCoord lastPosition;
 
 	assert(currentNode != description.Nodes().end());
 
 	auto time = std::chrono::system_clock::now();
 
-	lastPosition = currentNode->GetLocation();
+	const RouteTable table(description);
 
 	{
 		osmscout::RouteDescription::MaxSpeedDescriptionRef maxSpeedPath = std::dynamic_pointer_cast<osmscout::RouteDescription::MaxSpeedDescription>(currentNode->GetDescription(osmscout::RouteDescription::WAY_MAXSPEED_DESC));
@@ -34,44 +92,43 @@ PathGenerator::PathGenerator(const osmscout::RouteDescription& description,
 		if (maxSpeedPath) {
 			maxSpeed = maxSpeedPath->GetMaxSpeed();
 		}
-
-		steps.emplace_back(time, maxSpeed, lastPosition);
-		time += std::chrono::seconds(1);
 	}
 
+	// First the segment speeds, so we know how many steps we get
+	std::vector<double> speeds;
+	speeds.reserve(table.SegmentCount());
+	auto startSpeed = maxSpeed;
 
-	++nextNode;
-
-	while (nextNode != description.Nodes().end()) {
+	for (size_t segment = 0; segment < table.SegmentCount(); segment++, ++currentNode) {
 		osmscout::RouteDescription::MaxSpeedDescriptionRef maxSpeedPath = std::dynamic_pointer_cast<osmscout::RouteDescription::MaxSpeedDescription>(currentNode->GetDescription(osmscout::RouteDescription::WAY_MAXSPEED_DESC));
 
 		if (maxSpeedPath) {
 			maxSpeed = maxSpeedPath->GetMaxSpeed();
 		}
 
-		osmscout::Distance distance = osmscout::GetEllipsoidalDistance(currentNode->GetLocation(),
-			nextNode->GetLocation());
-		double bearing = osmscout::GetSphericalBearingInitial(currentNode->GetLocation(),
-			nextNode->GetLocation());
+		totalTime += table.Length(segment) / maxSpeed;
+
+		speeds.push_back(maxSpeed);
+	}
+
+	steps.reserve(static_cast<size_t>(totalTime * 60 * 60) + 2);
 
-		auto distanceInKilometer = distance.As<osmscout::Kilometer>();
-		auto timeInHours = distanceInKilometer / maxSpeed;
-		auto timeInSeconds = timeInHours * 60 * 60;
+	steps.emplace_back(time, startSpeed, table.Node(0));
+	time += std::chrono::seconds(1);
 
-		totalTime += timeInHours;
+	for (size_t segment = 0; segment < table.SegmentCount(); segment++) {
+		const auto speed = speeds[segment];
+		auto timeInSeconds = table.Length(segment) / speed * 60 * 60;
 
-		// Make sure we do not skip edges in the street
-		lastPosition = currentNode->GetLocation();
+		// Make sure we do not skip edges in the street, every segment is measured from its start node
+		double offsetInKilometer = 0.0;
 
 		while (timeInSeconds > 1.0 - restTime) {
 			timeInSeconds = timeInSeconds - (1.0 - restTime);
 
-			double segmentDistance = maxSpeed * (1.0 - restTime) / (60 * 60);
-
-			lastPosition = lastPosition.Add(bearing * 180 / M_PI,
-				osmscout::Distance::Of<osmscout::Kilometer>(segmentDistance));
+			offsetInKilometer += speed * (1.0 - restTime) / (60 * 60);
 
-			steps.emplace_back(time, maxSpeed, lastPosition);
+			steps.emplace_back(time, speed, table.Interpolate(segment, offsetInKilometer));
 			time += std::chrono::seconds(1);
 
 			restTime = 0;
@@ -80,10 +137,122 @@ PathGenerator::PathGenerator(const osmscout::RouteDescription& description,
 		}
 
 		restTime = timeInSeconds;
+	}
+
+	steps.emplace_back(time, maxSpeed, table.Node(table.NodeCount() - 1));
+}
+
+/**
+ * Steps in 1 / model.tickRate intervals. The vehicle starts and stops at rest,
+ * accelerates up to the speed limit and brakes in time for turns, junctions and
+ * roundabouts. The node speeds are first limited forward by the acceleration and
+ * backward by the deceleration, so every node is reachable and can be left in time.
+ *
+ * @param description
+ *    Routing description
+ * @param maxSpeed
+ *    Max speed to use if no explicit speed limit in given on a route segment
+ * @param model
+ *    Acceleration, braking and turn speeds of the vehicle
+ */
+PathGenerator::PathGenerator(const osmscout::RouteDescription& description,
+	double maxSpeed,
+	const DrivingModel& model)
+{
+	const auto& nodes = description.Nodes();
+
+	assert(!nodes.empty());
+	assert(model.tickRate > 0 && model.acceleration > 0 && model.deceleration > 0);
+
+	const RouteTable     table(description);
+	const auto           segmentCount = table.SegmentCount();
+	std::vector<double>  segmentSpeeds;   // m/s
+	std::vector<double>  nodeSpeeds;      // m/s
+	auto                 inRoundabout = false;
+
+	segmentSpeeds.reserve(segmentCount);
+	nodeSpeeds.reserve(table.NodeCount());
+
+	for (auto node = nodes.begin(); node != nodes.end(); ++node) {
+		osmscout::RouteDescription::MaxSpeedDescriptionRef maxSpeedPath = std::dynamic_pointer_cast<osmscout::RouteDescription::MaxSpeedDescription>(node->GetDescription(osmscout::RouteDescription::WAY_MAXSPEED_DESC));
+
+		if (maxSpeedPath) {
+			maxSpeed = maxSpeedPath->GetMaxSpeed();
+		}
+		if (node->HasDescription(osmscout::RouteDescription::ROUNDABOUT_ENTER_DESC)) {
+			inRoundabout = true;
+		}
+		if (node->HasDescription(osmscout::RouteDescription::ROUNDABOUT_LEAVE_DESC)) {
+			inRoundabout = false;
+		}
+
+		nodeSpeeds.push_back(NodeSpeed(*node, model) / 3.6);
+
+		if (segmentSpeeds.size() < segmentCount) {
+			segmentSpeeds.push_back((inRoundabout ? std::min(maxSpeed, model.roundaboutSpeed) : maxSpeed) / 3.6);
+		}
+	}
+
+	// Start and stop at rest, no node faster than the segments around it
+	nodeSpeeds.front() = 0.0;
+	nodeSpeeds.back() = 0.0;
+	for (size_t i = 0; i < segmentCount; i++) {
+		nodeSpeeds[i] = std::min(nodeSpeeds[i], segmentSpeeds[i]);
+		nodeSpeeds[i + 1] = std::min(nodeSpeeds[i + 1], segmentSpeeds[i]);
+	}
+	for (size_t i = 0; i < segmentCount; i++) {
+		nodeSpeeds[i + 1] = std::min(nodeSpeeds[i + 1],
+			std::sqrt(nodeSpeeds[i] * nodeSpeeds[i] + 2 * model.acceleration * table.Length(i) * 1000));
+	}
+	for (size_t i = segmentCount; i > 0; i--) {
+		nodeSpeeds[i - 1] = std::min(nodeSpeeds[i - 1],
+			std::sqrt(nodeSpeeds[i] * nodeSpeeds[i] + 2 * model.deceleration * table.Length(i - 1) * 1000));
+	}
+
+	const auto tick = 1.0 / model.tickRate;
+	const auto start = std::chrono::system_clock::now();
+	size_t     tickCount = 0;
+	size_t     segment = 0;
+	double     driven = 0.0;   // m from the start of the route
+	double     speed = 0.0;    // m/s
+
+	// Time from the tick count, so the 1 / tickRate steps do not add up rounding errors
+	auto timeOfTick = [start, tick](size_t count) {
+		return start + std::chrono::duration_cast<osmscout::Timestamp::duration>(std::chrono::duration<double>(count * tick));
+	};
+
+	// At least that many ticks, more for accelerating and braking
+	double totalTime = 0.0;
+	for (size_t i = 0; i < segmentCount; i++) {
+		totalTime += table.Length(i) * 1000 / segmentSpeeds[i];
+	}
+	steps.reserve(static_cast<size_t>(totalTime * model.tickRate) + 2);
+	steps.emplace_back(start, 0.0, table.Node(0));
+
+	while (segment < segmentCount) {
+		const auto nextSpeed = nodeSpeeds[segment + 1];
+		const auto brakingDistance = std::max(0.0, table.Cumulative(segment + 1) * 1000 - driven - speed * tick);
+
+		auto newSpeed = std::min(speed + model.acceleration * tick, segmentSpeeds[segment]);
+		newSpeed = std::min(newSpeed, std::sqrt(nextSpeed * nextSpeed + 2 * model.deceleration * brakingDistance));
+		newSpeed = std::max(newSpeed, std::min(CrawlSpeed, speed + model.acceleration * tick));
+
+		driven += (speed + newSpeed) / 2 * tick;
+		speed = newSpeed;
+
+		while (segment < segmentCount && driven >= table.Cumulative(segment + 1) * 1000) {
+			++segment;
+		}
+		if (segment == segmentCount) {
+			break;
+		}
+
+		tickCount++;
 
-		++currentNode;
-		++nextNode;
+		steps.emplace_back(timeOfTick(tickCount), speed * 3.6,
+			table.Interpolate(segment, driven / 1000 - table.Cumulative(segment)));
 	}
 
-	steps.emplace_back(time, maxSpeed, currentNode->GetLocation());
+	tickCount++;
+	steps.emplace_back(timeOfTick(tickCount), 0.0, table.Node(table.NodeCount() - 1));
 }
@@ -9,5 +9,22 @@ class PathGenerator : public IPathGenerator
 {
 
 public:
+	/**
+	 * How the vehicle drives the route in the route aware mode, speeds in km/h
+	 */
+	struct DrivingModel
+	{
+		double tickRate;        // steps per second
+		double acceleration;    // m/s²
+		double deceleration;    // m/s², braking without skidding
+		double sharpTurnSpeed;
+		double turnSpeed;
+		double junctionSpeed;   // slight turn into another street
+		double roundaboutSpeed; // in, into and out of a roundabout
+
+		DrivingModel();
+	};
+
 	PathGenerator(const osmscout::RouteDescription& description, double maxSpeed);
+	PathGenerator(const osmscout::RouteDescription& description, double maxSpeed, const DrivingModel& model);
 };
@@ -8,55 +8,376 @@
  *    Max speed to use if no explicit speed limit in given on a route segment
  */
 #include <chrono>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
 #include <osmscout/routing/Route.h>
 #include <osmscout/util/Geometry.h>
 #include "PathGeneratorNMEA.h"
 #include <iostream>
 #include "utils/easylogging++.h"
 #include "NMEADecoder.h"
+#include "NMEAFixBatch.h"
+#include "GeoDistance.h"
+#include "NMEALogFile.h"
+#include "TrackCache.h"
 
-PathGeneratorNMEA::PathGeneratorNMEA(const std::string& filename, double maxSpeed) {
-	//Todo Implement
-	_filename = filename;
-	_maxSpeed = maxSpeed;
+//Smaller logs are not worth a thread
+static const size_t MinChunkSize = 4 * 1024 * 1024;
+//RMC, GGA, GSA and GSV for every second, only used to reserve the steps
+static const size_t EstimatedBytesPerStep = 256;
+//Complete fixes the head of the log is read for, by then every sentence of an epoch was seen once
+static const size_t HeadFixes = 2;
+//Only if there are no complete fixes at all
+static const size_t MaxHeadSize = 256 * 1024;
+
+/**
+ * Collects steps, first and farthest fix while the log is decoded
+ */
+struct PathGeneratorNMEA::TrackCollector
+{
+	StepTrack          steps;
+	osmscout::GeoCoord firstPos;
+	osmscout::GeoCoord farthestPos;
+	bool               firstPosValid;
+	bool               farthestPosValid;
+	bool               keepSteps;
+	double             distanceInKilometerLast;
+	std::vector<double> lats; //Positions of the current batch for GeoDistance
+	std::vector<double> lons;
+
+	TrackCollector()
+		: firstPosValid(false),
+		farthestPosValid(false),
+		keepSteps(true),
+		distanceInKilometerLast(0.0)
+	{
+		// no code
+	}
+
+	void Add(const NMEADecoder& decoder)
+	{
+		if (!decoder.IsPositionValid()) return;
+
+		const osmscout::GeoCoord currentPos(decoder.GetLatitude(), decoder.GetLongitude());
+		AddPos(currentPos);
+
+		if (keepSteps && decoder.IsSpeedValid() && decoder.IsTimestampValid()) {
+			steps.emplace_back(decoder.GetTimePoint(), decoder.GetSpeed(), currentPos,
+				decoder.IsHdopValid() ? decoder.GetHdop() : 0.0,
+				decoder.IsSatellitesInUseValid() ? decoder.GetSatellitesInUse() : 0,
+				decoder.GetFixType());
+		}
+	}
+
+	void Add(const NMEAFixBatch& batch)
+	{
+		const auto count = batch.Size();
+		lats.resize(count);
+		lons.resize(count);
+		for (size_t i = 0; i < count; i++) {
+			lats[i] = batch.Latitude(i);
+			lons[i] = batch.Longitude(i);
+		}
+
+		size_t begin = 0;
+		if (!firstPosValid && count > 0) {
+			firstPos = osmscout::GeoCoord(lats[0], lons[0]);
+			firstPosValid = true;
+			begin = 1;
+		}
+		if (firstPos.GetLat() != 0 && begin < count) {
+			size_t index;
+			if (GeoDistance::FindFarthest(firstPos, lats.data() + begin, lons.data() + begin, count - begin,
+				distanceInKilometerLast, index)) {
+				farthestPos = osmscout::GeoCoord(lats[begin + index], lons[begin + index]);
+				farthestPosValid = true;
+			}
+		}
+
+		if (!keepSteps) return;
+		for (size_t i = 0; i < count; i++) {
+			if (batch.IsValid(i, NMEAFixBatch::SpeedValid | NMEAFixBatch::TimestampValid)) {
+				const osmscout::Timestamp time(std::chrono::duration_cast<osmscout::Timestamp::duration>(
+					std::chrono::milliseconds(batch.TimeMilliseconds(i))));
+				steps.emplace_back(time, batch.Speed(i), osmscout::GeoCoord(lats[i], lons[i]),
+					batch.IsValid(i, NMEAFixBatch::HdopValid) ? batch.Hdop(i) : 0.0,
+					batch.IsValid(i, NMEAFixBatch::SatellitesValid) ? batch.Satellites(i) : 0,
+					batch.FixType(i));
+			}
+		}
+	}
+
+	void AddPos(const osmscout::GeoCoord& currentPos)
+	{
+		if (!firstPosValid) {
+			firstPos = currentPos;
+			firstPosValid = true;
+		} else if (firstPos.GetLat() != 0) {
+			const auto distanceInKilometer = osmscout::GetEllipsoidalDistance(currentPos, firstPos).As<osmscout::Kilometer>();
+			Farthest(currentPos, distanceInKilometer);
+		}
+	}
+
+	void Farthest(const osmscout::GeoCoord& pos, double distanceInKilometer)
+	{
+		//Only bigger, so the first of equal distant fixes wins
+		if (distanceInKilometer > distanceInKilometerLast) {
+			distanceInKilometerLast = distanceInKilometer;
+			farthestPos = pos;
+			farthestPosValid = true;
+		}
+	}
+
+	void Append(TrackCollector& other)
+	{
+		steps.append(other.steps);
+		if (other.farthestPosValid) {
+			Farthest(other.farthestPos, other.distanceInKilometerLast);
+		}
+	}
+};
+
+/**
+ * One part of the log decoded by its own thread
+ */
+struct PathGeneratorNMEA::Chunk
+{
+	const char*    begin;
+	const char*    end;
+	const char*    completeAt; //Sentences before are decoded again with the state of the previous chunk
+	uint8_t        requiredQuality;   //NMEADecoder::Quality the log sends
+	uint8_t        qualityAtComplete; //NMEADecoder::Quality the decoder had at completeAt
+	NMEADecoder    decoder;
+	TrackCollector collector;
+
+	Chunk(const char* begin, const char* end, uint8_t requiredQuality)
+		: begin(begin),
+		end(end),
+		completeAt(end),
+		requiredQuality(requiredQuality),
+		qualityAtComplete(0)
+	{
+		// no code
+	}
+};
+
+PathGeneratorNMEA::PathGeneratorNMEA(const NMEALogFile& log, double maxSpeed):
+	_log(log),
+	_maxSpeed(maxSpeed),
+	_firstPosValid(false),
+	_farthestPosValid(false) {
+}
+
+void PathGeneratorNMEA::Decode(NMEADecoder& decoder, const char* begin, const char* end, TrackCollector& collector) {
+	NMEAFixBatch batch;
+	while (begin < end) {
+		begin = decoder.DecodeBatch(begin, end, batch);
+		collector.Add(batch);
+	}
+}
+
+void PathGeneratorNMEA::DecodeChunk(Chunk& chunk) {
+	//Wait for a sentence that sets the whole state, from there on the result is the same as for one sequential pass
+	NMEALineReader reader(chunk.begin, chunk.end);
+	const char* line;
+	size_t length;
+	while (reader.Next(line, length)) {
+		if (chunk.decoder.Decode(line, length) && chunk.decoder.IsFixComplete(chunk.requiredQuality)) {
+			chunk.completeAt = line;
+			chunk.qualityAtComplete = chunk.decoder.GetQualityValid();
+			chunk.collector.Add(chunk.decoder);
+			break;
+		}
+	}
+	Decode(chunk.decoder, reader.Position(), chunk.end, chunk.collector);
+}
+
+void PathGeneratorNMEA::Finish(const TrackCollector& collector, const NMEAChecksumStats& checksumStats) {
+	_firstPos = collector.firstPos;
+	_firstPosValid = collector.firstPosValid;
+	_farthestPos = collector.farthestPos;
+	_farthestPosValid = collector.farthestPosValid;
+
+	LOG(INFO) << checksumStats.rejected << " of " << checksumStats.checked << " sentences rejected ("
+		<< checksumStats.missing << " without checksum)";
 }
 
 bool PathGeneratorNMEA::GenerateSteps() {
 	NMEADecoder decoder;
+	TrackCollector collector;
+	collector.steps.reserve(_log.Size() / EstimatedBytesPerStep);
+
+	Decode(decoder, _log.Data(), _log.Data() + _log.Size(), collector);
+	steps = std::move(collector.steps);
+
+	Finish(collector, decoder.GetChecksumStats());
+	return _firstPosValid;
+}
+
+bool PathGeneratorNMEA::FindFirstAndFarthestPos() {
+	NMEADecoder decoder;
+	TrackCollector collector;
+	collector.keepSteps = false;
+
+	Decode(decoder, _log.Data(), _log.Data() + _log.Size(), collector);
+
+	Finish(collector, decoder.GetChecksumStats());
+	return _firstPosValid;
+}
 
-	std::ifstream file(_filename);
-	if (!file.is_open()) {
-		LOG(ERROR) << "Error Open File";
-		std::cout << "Error Open File";
-		return false;
-	}
-
-	auto time = std::chrono::system_clock::now();
-	osmscout::GeoCoord lastPos(0, 0);
-
-	std::string line;
-	while (std::getline(file, line)) {
-		if (decoder.Decode(line)) {
-			//LOG(DEBUG) << "Line Read and decode " << line;
-			if (decoder.IsPositionValid() && decoder.IsSpeedValid() && decoder.IsTimestampValid()) {
-				const auto curtargetLat = decoder.GetLatitude();
-				const auto curtargetLon = decoder.GetLongitude();
-				const auto speed = decoder.GetSpeed();
-				const osmscout::GeoCoord currentPos(curtargetLat, curtargetLon);
-				steps.emplace_back(std::chrono::system_clock::from_time_t(decoder.GetTimestamp()), speed, currentPos);
-				/*if(lastPos.GetLat() == 0) {
-					steps.emplace_back(time, speed, currentPos);
-					lastPos.Set(curtargetLat, curtargetLon);
-				} else {
-					auto distance = GetEllipsoidalDistance(currentPos, lastPos);
-					const auto distanceInKilometer = distance.As<osmscout::Kilometer>();
-					const auto timeInHours = distanceInKilometer / speed;
-					int64_t timeInSeconds = timeInHours * 60 * 60;
-					time += std::chrono::seconds(timeInSeconds);
-					steps.emplace_back(time, speed, currentPos);
-				}*/
+bool PathGeneratorNMEA::GenerateStepsParallel(unsigned threadCount) {
+	const auto size = _log.Size();
+	if (threadCount > size / MinChunkSize) {
+		threadCount = static_cast<unsigned>(size / MinChunkSize);
+	}
+	if (threadCount <= 1) {
+		return GenerateSteps();
+	}
+
+	const auto data = _log.Data();
+	const auto dataEnd = data + size;
+
+	//The other chunks need the first fix of the log to look for the farthest one, and which
+	//quality values (HDOP, satellites, fix type) the receiver sends before their state is complete
+	TrackCollector head;
+	head.keepSteps = false;
+	uint8_t requiredQuality;
+	{
+		NMEADecoder decoder;
+		NMEALineReader reader(data, dataEnd);
+		const char* line;
+		size_t length;
+		size_t completeFixes = 0;
+		while (reader.Next(line, length)) {
+			if (decoder.Decode(line, length)) {
+				head.Add(decoder);
+				if (decoder.IsFixComplete(0)) completeFixes++;
+			}
+			if (head.firstPosValid &&
+				(completeFixes >= HeadFixes || static_cast<size_t>(reader.Position() - data) > MaxHeadSize)) {
+				break;
 			}
 		}
+		if (!head.firstPosValid) {
+			Finish(head, decoder.GetChecksumStats());
+			return false;
+		}
+		requiredQuality = decoder.GetQualityValid();
+	}
+
+	//Chunks end behind a line feed
+	std::vector<std::unique_ptr<Chunk>> chunks;
+	auto chunkBegin = data;
+	for (unsigned i = 1; i <= threadCount && chunkBegin < dataEnd; i++) {
+		auto chunkEnd = dataEnd;
+		if (i < threadCount) {
+			chunkEnd = data + size / threadCount * i;
+			if (chunkEnd < chunkBegin) chunkEnd = chunkBegin;
+			const auto lineFeed = static_cast<const char*>(std::memchr(chunkEnd, '\n', dataEnd - chunkEnd));
+			chunkEnd = lineFeed != nullptr ? lineFeed + 1 : dataEnd;
+		}
+		chunks.emplace_back(new Chunk(chunkBegin, chunkEnd, requiredQuality));
+		chunkBegin = chunkEnd;
+	}
+
+	//The first chunk starts with the state of the log, it is complete from the first line
+	chunks[0]->completeAt = chunks[0]->begin;
+	for (size_t i = 1; i < chunks.size(); i++) {
+		chunks[i]->collector.firstPos = head.firstPos;
+		chunks[i]->collector.firstPosValid = true;
+	}
+
+	std::vector<std::thread> workers;
+	workers.reserve(chunks.size());
+	workers.emplace_back([&chunks]() {
+		Decode(chunks[0]->decoder, chunks[0]->begin, chunks[0]->end, chunks[0]->collector);
+	});
+	for (size_t i = 1; i < chunks.size(); i++) {
+		auto chunk = chunks[i].get();
+		workers.emplace_back([chunk]() {
+			DecodeChunk(*chunk);
+		});
+	}
+	for (auto& worker : workers) {
+		worker.join();
+	}
+
+	//Stitch in log order, the sentences of a chunk before its first complete fix are decoded again
+	//with the state the previous chunk ends with (date, time of day, speed, quality values)
+	auto& collector = chunks[0]->collector;
+	size_t stepCount = 0;
+	for (const auto& chunk : chunks) {
+		stepCount += chunk->collector.steps.size();
+	}
+	collector.steps.reserve(stepCount);
+
+	auto checksumStats = chunks[0]->decoder.GetChecksumStats();
+	NMEADecoder state = chunks[0]->decoder;
+	for (size_t i = 1; i < chunks.size(); i++) {
+		auto& chunk = *chunks[i];
+		TrackCollector prefix;
+		prefix.firstPos = head.firstPos;
+		prefix.firstPosValid = true;
+		//A quality value the log only started to send after its head is unknown to the chunk,
+		//its steps would lack what the sequential pass has. The whole chunk is decoded again then.
+		const auto reuseChunk = chunk.completeAt != chunk.end &&
+			(state.GetQualityValid() & ~chunk.qualityAtComplete) == 0;
+		if (reuseChunk) {
+			Decode(state, chunk.begin, chunk.completeAt, prefix);
+			collector.Append(prefix);
+			collector.Append(chunk.collector);
+			state = chunk.decoder;
+		} else {
+			Decode(state, chunk.begin, chunk.end, prefix);
+			collector.Append(prefix);
+		}
+
+		const auto& chunkStats = chunk.decoder.GetChecksumStats();
+		checksumStats.checked += chunkStats.checked;
+		checksumStats.rejected += chunkStats.rejected;
+		checksumStats.missing += chunkStats.missing;
 	}
-	return false;
+
+	steps = std::move(collector.steps);
+	Finish(collector, checksumStats);
+	return _firstPosValid;
+}
+
+bool PathGeneratorNMEA::LoadOrGenerateSteps(unsigned threadCount) {
+	TrackCacheInfo info;
+	if (TrackCache::Load(_log.GetFilename(), steps, info)) {
+		LOG(INFO) << "Steps loaded from " << TrackCache::GetCacheFilename(_log.GetFilename());
+		_firstPos = info.firstPos;
+		_firstPosValid = info.firstPosValid;
+		_farthestPos = info.farthestPos;
+		_farthestPosValid = info.farthestPosValid;
+		return _firstPosValid;
+	}
+
+	const auto result = GenerateStepsParallel(threadCount);
+
+	info.firstPos = _firstPos;
+	info.firstPosValid = _firstPosValid;
+	info.farthestPos = _farthestPos;
+	info.farthestPosValid = _farthestPosValid;
+	if (!TrackCache::Save(_log.GetFilename(), steps, info)) {
+		LOG(WARNING) << "Can't write track cache for " << _log.GetFilename();
+	}
+	return result;
+}
+
+bool PathGeneratorNMEA::GetFirstPos(double& lat, double& lon) const {
+	if (!_firstPosValid) return false;
+	lat = _firstPos.GetLat();
+	lon = _firstPos.GetLon();
+	return true;
+}
+
+bool PathGeneratorNMEA::GetFarthestPos(double& lat, double& lon) const {
+	if (!_farthestPosValid) return false;
+	lat = _farthestPos.GetLat();
+	lon = _farthestPos.GetLon();
+	return true;
 }
@@ -5,11 +5,45 @@ namespace osmscout {
 	class RouteDescription;
 }
 
+class NMEALogFile;
+class NMEADecoder;
+struct NMEAChecksumStats;
+
 class PathGeneratorNMEA : public IPathGenerator
 {
-	std::string _filename;
+	const NMEALogFile& _log;
 	double _maxSpeed;
+	osmscout::GeoCoord _firstPos;
+	osmscout::GeoCoord _farthestPos;
+	bool _firstPosValid;
+	bool _farthestPosValid;
+
+	struct TrackCollector;
+	struct Chunk;
+	static void Decode(NMEADecoder& decoder, const char* begin, const char* end, TrackCollector& collector);
+	static void DecodeChunk(Chunk& chunk);
+	void Finish(const TrackCollector& collector, const NMEAChecksumStats& checksumStats);
 public:
-	PathGeneratorNMEA(const std::string& filename, double maxSpeed);
+	PathGeneratorNMEA(const NMEALogFile& log, double maxSpeed);
+	/**
+	 * One pass over the log, fills the steps and finds the first valid fix
+	 * and the fix farthest away from it
+	 */
 	bool GenerateSteps();
+	/**
+	 * Same result as GenerateSteps, the log is split at line ends and every part
+	 * is decoded by its own thread
+	 */
+	bool GenerateStepsParallel(unsigned threadCount);
+	/**
+	 * Use the track cache beside the log, if there is none or it is too old
+	 * decode the log and write a new one
+	 */
+	bool LoadOrGenerateSteps(unsigned threadCount);
+	/**
+	 * Only first and farthest fix, no steps are stored. For use with NMEAStepSource
+	 */
+	bool FindFirstAndFarthestPos();
+	bool GetFirstPos(double& lat, double& lon) const;
+	bool GetFarthestPos(double& lat, double& lon) const;
 };
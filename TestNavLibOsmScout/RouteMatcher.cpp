@@ -0,0 +1,238 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "RouteMatcher.h"
+
+//About 1 km, a city route touches some hundred cells
+static const double CellSizeInDegree = 0.01;
+static const int64_t LatCells = 18000;
+static const int64_t LonCells = 36000;
+//Mean earth radius, the tangent plane is only used some hundred meters around the fix
+static const double MeterPerDegree = 6371008.8 * M_PI / 180.0;
+
+static int64_t LatCell(double lat) {
+	return std::min(std::max(static_cast<int64_t>(std::floor((lat + 90.0) / CellSizeInDegree)), int64_t(0)), LatCells - 1);
+}
+
+static int64_t LonCell(double lon) {
+	return std::min(std::max(static_cast<int64_t>(std::floor((lon + 180.0) / CellSizeInDegree)), int64_t(0)), LonCells - 1);
+}
+
+static uint64_t CellKey(int64_t latCell, int64_t lonCell) {
+	//The grid goes around the date line
+	lonCell = (lonCell % LonCells + LonCells) % LonCells;
+	return (static_cast<uint64_t>(latCell) << 32) | static_cast<uint64_t>(lonCell);
+}
+
+static double WrapLon(double deltaLon) {
+	if (deltaLon > 180.0) {
+		return deltaLon - 360.0;
+	}
+	if (deltaLon < -180.0) {
+		return deltaLon + 360.0;
+	}
+	return deltaLon;
+}
+
+RouteMatcher::RouteMatcher(const osmscout::RouteDescription& description,
+	double snapDistanceInMeter,
+	double windowInKilometer)
+	: _table(description),
+	_snapDistance(snapDistanceInMeter),
+	_window(windowInKilometer),
+	_cursor(0),
+	_misses(0)
+{
+	BuildGrid();
+}
+
+void RouteMatcher::BuildGrid() {
+	//Every segment is sampled at half the cell size, a cell it only cuts at a corner is
+	//found from the neighbour cell when looking up
+	for (size_t segment = 0; segment < _table.SegmentCount(); segment++) {
+		const auto from = _table.Node(segment);
+		const auto to = _table.Node(segment + 1);
+		const auto deltaLat = to.GetLat() - from.GetLat();
+		const auto deltaLon = WrapLon(to.GetLon() - from.GetLon());
+		const auto samples = static_cast<size_t>(std::ceil(std::max(std::fabs(deltaLat), std::fabs(deltaLon)) / (CellSizeInDegree / 2.0)));
+
+		for (size_t i = 0; i <= samples; i++) {
+			const auto fraction = samples > 0 ? static_cast<double>(i) / samples : 0.0;
+			const auto lat = from.GetLat() + fraction * deltaLat;
+			const auto lon = from.GetLon() + WrapLon(fraction * deltaLon);
+			auto& cell = _grid[CellKey(LatCell(lat), LonCell(WrapLon(lon)))];
+			if (cell.empty() || cell.back() != segment) {
+				cell.push_back(static_cast<uint32_t>(segment));
+			}
+		}
+	}
+}
+
+void RouteMatcher::Reset() {
+	_cursor = 0;
+	_misses = 0;
+}
+
+void RouteMatcher::MatchSegment(const osmscout::GeoCoord& position, size_t segment, Match& best) const {
+	//Closest point in the tangent plane of the fix, the fix is the origin
+	const auto metersPerLonDegree = MeterPerDegree * std::cos(position.GetLat() * M_PI / 180.0);
+	const auto from = _table.Node(segment);
+	const auto to = _table.Node(segment + 1);
+	const auto fromX = WrapLon(from.GetLon() - position.GetLon()) * metersPerLonDegree;
+	const auto fromY = (from.GetLat() - position.GetLat()) * MeterPerDegree;
+	const auto deltaX = WrapLon(to.GetLon() - from.GetLon()) * metersPerLonDegree;
+	const auto deltaY = (to.GetLat() - from.GetLat()) * MeterPerDegree;
+	const auto lengthSquared = deltaX * deltaX + deltaY * deltaY;
+
+	auto fraction = lengthSquared > 0.0 ? -(fromX * deltaX + fromY * deltaY) / lengthSquared : 0.0;
+	fraction = std::min(std::max(fraction, 0.0), 1.0);
+
+	const auto x = fromX + fraction * deltaX;
+	const auto y = fromY + fraction * deltaY;
+	const auto distance = std::sqrt(x * x + y * y);
+
+	//Equal distances go to the earlier segment, the node between two segments belongs to both
+	if (distance < best.distance || (distance == best.distance && segment < best.segment)) {
+		best.segment = segment;
+		best.offset = fraction * _table.Length(segment);
+		best.distance = distance;
+	}
+}
+
+bool RouteMatcher::MatchWindow(const osmscout::GeoCoord& position, Match& best) const {
+	//One segment back for fixes that lag behind the node just passed
+	const auto first = _cursor > 0 ? _cursor - 1 : 0;
+	const auto end = _table.Cumulative(std::min(_cursor + 1, _table.SegmentCount())) + _window;
+	auto found = false;
+
+	for (auto segment = first; segment < _table.SegmentCount(); segment++) {
+		if (segment > _cursor + 1 && _table.Cumulative(segment) > end) {
+			break;
+		}
+
+		Match candidate;
+		candidate.distance = std::numeric_limits<double>::max();
+		MatchSegment(position, segment, candidate);
+
+		//The first pass near the fix wins, a later leg of the route on the same street must not
+		if (candidate.distance <= _snapDistance) {
+			found = true;
+		}
+		else if (found) {
+			break;
+		}
+
+		if (candidate.distance < best.distance) {
+			best = candidate;
+		}
+	}
+
+	return found;
+}
+
+void RouteMatcher::MatchPass(const osmscout::GeoCoord& position, size_t first, Match& best) const {
+	//The segments from first on that stay within the snap distance are one pass near the fix
+	for (auto segment = first; segment < _table.SegmentCount(); segment++) {
+		Match candidate;
+		candidate.distance = std::numeric_limits<double>::max();
+		MatchSegment(position, segment, candidate);
+		if (candidate.distance > _snapDistance) {
+			break;
+		}
+		if (candidate.distance < best.distance) {
+			best = candidate;
+		}
+	}
+}
+
+bool RouteMatcher::MatchGrid(const osmscout::GeoCoord& position, size_t firstSegment, Match& best) const {
+	const auto snapInDegree = _snapDistance / MeterPerDegree;
+	const auto cosLat = std::max(std::cos(position.GetLat() * M_PI / 180.0), 0.01);
+	const auto latRing = 1 + static_cast<int64_t>(std::ceil(snapInDegree / CellSizeInDegree));
+	const auto lonRing = 1 + static_cast<int64_t>(std::ceil(snapInDegree / (CellSizeInDegree * cosLat)));
+	const auto latCell = LatCell(position.GetLat());
+	const auto lonCell = LonCell(position.GetLon());
+	auto first = _table.SegmentCount();
+
+	for (auto lat = std::max(latCell - latRing, int64_t(0)); lat <= std::min(latCell + latRing, LatCells - 1); lat++) {
+		for (auto lon = lonCell - lonRing; lon <= lonCell + lonRing; lon++) {
+			const auto cell = _grid.find(CellKey(lat, lon));
+			if (cell == _grid.end()) {
+				continue;
+			}
+			//Normally from the cursor on, a segment already passed would send the navigation back
+			for (const auto segment : cell->second) {
+				if (segment < firstSegment) {
+					continue;
+				}
+				Match candidate;
+				candidate.distance = std::numeric_limits<double>::max();
+				MatchSegment(position, segment, candidate);
+				if (candidate.distance <= _snapDistance && segment < first) {
+					first = segment;
+				}
+				if (candidate.distance < best.distance) {
+					best = candidate;
+				}
+			}
+		}
+	}
+
+	if (first == _table.SegmentCount()) {
+		return false;
+	}
+
+	//The first pass from firstSegment on wins as in the window, not a later leg of the route nearer to the fix
+	best.distance = std::numeric_limits<double>::max();
+	MatchPass(position, first, best);
+	return true;
+}
+
+RouteMatcher::Match RouteMatcher::Update(const osmscout::GeoCoord& position) {
+	Match window;
+	window.distance = std::numeric_limits<double>::max();
+	if (_table.SegmentCount() == 0) {
+		return window;
+	}
+
+	if (MatchWindow(position, window)) {
+		//A fix may lag a segment behind, going back further is not driving the route
+		if (window.segment < _cursor) {
+			_misses++;
+		}
+		else if (window.segment > _cursor) {
+			_misses = 0;
+		}
+		_cursor = window.segment;
+		window.onRoute = true;
+		return _misses >= ReseedMisses ? Reseed(position, window) : window;
+	}
+
+	//Not near the cursor, the vehicle jumped or left the route
+	Match jump;
+	jump.distance = std::numeric_limits<double>::max();
+	if (MatchGrid(position, _cursor, jump)) {
+		_cursor = jump.segment;
+		_misses = 0;
+		jump.onRoute = true;
+		return jump;
+	}
+
+	_misses++;
+	const auto& nearest = jump.distance < window.distance ? jump : window;
+	return _misses >= ReseedMisses ? Reseed(position, nearest) : nearest;
+}
+
+RouteMatcher::Match RouteMatcher::Reseed(const osmscout::GeoCoord& position, const Match& current) {
+	//The cursor went ahead on a glitch or the vehicle turned back, the first pass of the whole route wins
+	Match first;
+	first.distance = std::numeric_limits<double>::max();
+	if (!MatchGrid(position, 0, first)) {
+		return current;
+	}
+
+	_cursor = first.segment;
+	_misses = 0;
+	first.onRoute = true;
+	return first;
+}
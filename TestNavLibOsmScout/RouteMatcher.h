@@ -0,0 +1,78 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <osmscout/GeoCoord.h>
+#include "RouteTable.h"
+
+/**
+ * Matches fixes to the nearest segment of a route without scanning the whole route.
+ * A cursor stays on the last matched segment and only a window ahead of it is searched,
+ * so a fix costs the same on a short and on a long route. Only if the window has no segment
+ * within the snap distance (the vehicle jumped ahead, a tunnel without GPS) the segments
+ * around the fix are taken from a grid built once with the route, those at or after the cursor.
+ * After some fixes in a row near none of them, or going back on the route, the whole route is
+ * searched and the cursor starts again at the first pass near the fix. A glitch that moved it
+ * to a later leg, maybe the way back on the same street, is not kept for good.
+ */
+class RouteMatcher
+{
+public:
+	/**
+	 * Fixes off the route or backwards on it before the whole route is searched, 5 s at 1 Hz
+	 */
+	static const size_t ReseedMisses = 5;
+
+	struct Match
+	{
+		bool   onRoute;
+		size_t segment;
+		double offset;    // km behind the start of segment
+		double distance;  // m from the fix to the searched segments
+
+		Match()
+			: onRoute(false),
+			segment(0),
+			offset(0.0),
+			distance(0.0)
+		{
+			// no code
+		}
+	};
+
+	explicit RouteMatcher(const osmscout::RouteDescription& description,
+		double snapDistanceInMeter = 100.0,
+		double windowInKilometer = 1.0);
+
+	/**
+	 * Match the next fix, the cursor moves only if the fix is on the route. It goes back
+	 * more than a segment only after ReseedMisses fixes off the route or backwards on it.
+	 */
+	Match Update(const osmscout::GeoCoord& position);
+	/**
+	 * Start again at the beginning of the route
+	 */
+	void Reset();
+
+	const RouteTable& GetTable() const
+	{
+		return _table;
+	}
+
+private:
+	RouteTable _table;
+	double     _snapDistance;
+	double     _window;
+	size_t     _cursor;
+	size_t     _misses;   // fixes off the route or backwards since the last step forward
+	// Segments passing through a grid cell, key from CellKey
+	std::unordered_map<uint64_t, std::vector<uint32_t>> _grid;
+
+	void BuildGrid();
+	void MatchSegment(const osmscout::GeoCoord& position, size_t segment, Match& best) const;
+	void MatchPass(const osmscout::GeoCoord& position, size_t first, Match& best) const;
+	bool MatchWindow(const osmscout::GeoCoord& position, Match& best) const;
+	bool MatchGrid(const osmscout::GeoCoord& position, size_t firstSegment, Match& best) const;
+	Match Reseed(const osmscout::GeoCoord& position, const Match& current);
+};
@@ -0,0 +1,73 @@
+#include "RouteNavigation.h"
+
+RouteNavigation::RouteNavigation()
+	: _route(nullptr),
+	_table(nullptr),
+	_segment(0),
+	_distanceFromStart(0.0),
+	_durationFromStart(0.0)
+{
+	// no code
+}
+
+void RouteNavigation::SetRoute(const osmscout::RouteDescription* route, const RouteTable& table) {
+	_route = route;
+	_table = &table;
+	_nodes.clear();
+	_description.Clear();
+	_segment = 0;
+	_distanceFromStart = 0.0;
+	_durationFromStart = 0.0;
+	if (_route == nullptr) return;
+
+	_nodes.reserve(_route->Nodes().size());
+	for (auto node = _route->Nodes().begin(); node != _route->Nodes().end(); ++node) {
+		_nodes.push_back(node);
+	}
+
+	Restart();
+}
+
+void RouteNavigation::Restart() {
+	//The start instruction, before the first fix
+	_description.Clear();
+	_nextWaypoint = _route->Nodes().begin();
+	_description.NextDescription(osmscout::Distance::Of<osmscout::Meter>(-1.0), _nextWaypoint, _route->Nodes().end());
+}
+
+bool RouteNavigation::Update(const RouteMatcher::Match& match) {
+	if (_route == nullptr || !match.onRoute || match.segment + 1 >= _nodes.size()) return false;
+
+	//A fix lags at most one segment behind, further back the waypoints already passed are needed again
+	if (match.segment + 1 < _segment) {
+		Restart();
+	}
+	_segment = match.segment;
+
+	//The route distance and time of the nodes, the table length only gives the fraction of the segment
+	const auto& from = *_nodes[match.segment];
+	const auto& to = *_nodes[match.segment + 1];
+	const auto length = _table->Length(match.segment);
+	const auto fraction = length > 0.0 ? match.offset / length : 0.0;
+	_distanceFromStart = from.GetDistance().AsMeter() + fraction * (to.GetDistance().AsMeter() - from.GetDistance().AsMeter());
+	_durationFromStart = from.GetTime() + fraction * (to.GetTime() - from.GetTime());
+
+	_description.NextDescription(osmscout::Distance::Of<osmscout::Meter>(_distanceFromStart), _nextWaypoint, _route->Nodes().end());
+	return true;
+}
+
+osmscout::NodeDescription RouteNavigation::NextWaypointDescription() {
+	return _description.GetDescription();
+}
+
+osmscout::Distance RouteNavigation::GetDistance() const {
+	if (_nodes.empty()) return osmscout::Distance::Of<osmscout::Meter>(0.0);
+
+	return osmscout::Distance::Of<osmscout::Meter>(_route->Nodes().back().GetDistance().AsMeter() - _distanceFromStart);
+}
+
+double RouteNavigation::GetDuration() const {
+	if (_nodes.empty()) return 0.0;
+
+	return _route->Nodes().back().GetTime() - _durationFromStart;
+}
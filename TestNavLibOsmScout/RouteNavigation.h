@@ -0,0 +1,51 @@
+#pragma once
+#include <list>
+#include <vector>
+#include <osmscout/routing/Route.h>
+#include "NavigationDescription.h"
+#include "RouteMatcher.h"
+
+/**
+ * Position on the route and the next instruction, the same as osmscout::Navigation keeps them,
+ * but moved to the segment the RouteMatcher found. osmscout::Navigation measures every node
+ * of the route for every fix.
+ */
+class RouteNavigation
+{
+	typedef std::list<osmscout::RouteDescription::Node>::const_iterator NodeIterator;
+
+	const osmscout::RouteDescription*                          _route;
+	const RouteTable*                                          _table;
+	std::vector<NodeIterator>                                  _nodes;   // node i of the table
+	osmscout::NavigationDescription<osmscout::NodeDescription> _description;
+	NodeIterator                                               _nextWaypoint;
+	size_t                                                     _segment; // of the last match
+	double                                                     _distanceFromStart; // m
+	double                                                     _durationFromStart; // h
+
+	void Restart();
+
+public:
+	RouteNavigation();
+
+	/**
+	 * table has to be built from route and live as long as it is set
+	 */
+	void SetRoute(const osmscout::RouteDescription* route, const RouteTable& table);
+	/**
+	 * Move to the matched position, a match off the route changes nothing. If the
+	 * matcher went back on the route the instructions start again from the beginning.
+	 *
+	 * @return true if the match is on the route
+	 */
+	bool Update(const RouteMatcher::Match& match);
+	osmscout::NodeDescription NextWaypointDescription();
+	/**
+	 * Distance to the destination
+	 */
+	osmscout::Distance GetDistance() const;
+	/**
+	 * Hours to the destination
+	 */
+	double GetDuration() const;
+};
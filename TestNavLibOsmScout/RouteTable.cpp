@@ -0,0 +1,35 @@
+#include <osmscout/routing/Route.h>
+#include <osmscout/util/Geometry.h>
+#include "RouteTable.h"
+#include "GeoDistance.h"
+
+//Below this the relative error of GeoDistance stays under 2.5e-5 (ToleranceBase + ToleranceSquare * 5^2 in GeoDistance.cpp)
+static const double ExactDistanceInKilometer = 5.0;
+
+RouteTable::RouteTable(const osmscout::RouteDescription& description)
+{
+	const auto count = description.Nodes().size();
+
+	_lats.reserve(count);
+	_lons.reserve(count);
+	for (const auto& routeNode : description.Nodes()) {
+		_lats.push_back(routeNode.GetLocation().GetLat());
+		_lons.push_back(routeNode.GetLocation().GetLon());
+	}
+
+	// Segment lengths in one pass over the node positions, only long ones are measured exactly
+	_lengths.resize(count > 0 ? count - 1 : 0);
+	if (count > 1) {
+		GeoDistance::Successive(_lats.data(), _lons.data(), count, _lengths.data());
+	}
+
+	_cumulative.resize(count > 0 ? count : 1);
+	_cumulative[0] = 0.0;
+
+	for (size_t i = 0; i < _lengths.size(); i++) {
+		if (_lengths[i] > ExactDistanceInKilometer) {
+			_lengths[i] = osmscout::GetEllipsoidalDistance(Node(i), Node(i + 1)).As<osmscout::Kilometer>();
+		}
+		_cumulative[i + 1] = _cumulative[i] + _lengths[i];
+	}
+}
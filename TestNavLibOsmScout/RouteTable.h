@@ -0,0 +1,80 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include <osmscout/GeoCoord.h>
+
+namespace osmscout {
+	class RouteDescription;
+}
+
+/**
+ * The nodes of a route description as arrays, built once. Segment i goes from node i to node i + 1.
+ * Positions on a segment are interpolated linear in lat/lon, without trigonometry.
+ */
+class RouteTable
+{
+	std::vector<double> _lats;
+	std::vector<double> _lons;
+	std::vector<double> _lengths;      // km
+	std::vector<double> _cumulative;   // km from the start to node i
+
+public:
+	explicit RouteTable(const osmscout::RouteDescription& description);
+
+	size_t NodeCount() const
+	{
+		return _lats.size();
+	}
+
+	size_t SegmentCount() const
+	{
+		return _lengths.size();
+	}
+
+	osmscout::GeoCoord Node(size_t index) const
+	{
+		return osmscout::GeoCoord(_lats[index], _lons[index]);
+	}
+
+	double Length(size_t segment) const
+	{
+		return _lengths[segment];
+	}
+
+	double Cumulative(size_t node) const
+	{
+		return _cumulative[node];
+	}
+
+	double TotalLength() const
+	{
+		return _cumulative.back();
+	}
+
+	/**
+	 * Position offsetInKilometer behind the start of segment
+	 */
+	osmscout::GeoCoord Interpolate(size_t segment, double offsetInKilometer) const
+	{
+		const auto fraction = _lengths[segment] > 0.0 ? offsetInKilometer / _lengths[segment] : 0.0;
+		auto deltaLon = _lons[segment + 1] - _lons[segment];
+
+		// The short way over the date line
+		if (deltaLon > 180.0) {
+			deltaLon -= 360.0;
+		}
+		else if (deltaLon < -180.0) {
+			deltaLon += 360.0;
+		}
+
+		auto lon = _lons[segment] + fraction * deltaLon;
+		if (lon > 180.0) {
+			lon -= 360.0;
+		}
+		else if (lon < -180.0) {
+			lon += 360.0;
+		}
+
+		return osmscout::GeoCoord(_lats[segment] + fraction * (_lats[segment + 1] - _lats[segment]), lon);
+	}
+};
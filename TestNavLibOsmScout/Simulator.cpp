@@ -6,7 +6,14 @@
 
 #include "Simulator.h"
 #include "PathGenerator.h"
+#include "IStepSource.h"
 #include <iomanip>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+
+//Farther away from the route the vehicle is off the route
+static const double SnapDistanceInMeter = 100.0;
 
 static std::string TimeToString(double time)
 {
@@ -17,117 +24,193 @@ static std::string TimeToString(double time)
 	return stream.str();
 }
 
+enum class MessageType
+{
+	PositionChanged,
+	BearingChanged,
+	StreetChanged,
+	RouteStateChanged,
+	Other
+};
+
+/**
+ * One typeid and a hash lookup per message instead of a dynamic_cast per candidate type.
+ * The engine only sends the leaf message classes, so the exact type is enough.
+ */
+static MessageType ClassifyMessage(const osmscout::NavigationMessage& message)
+{
+	static const std::unordered_map<std::type_index, MessageType> types{
+		{ std::type_index(typeid(osmscout::PositionChangedMessage)), MessageType::PositionChanged },
+		{ std::type_index(typeid(osmscout::BearingChangedMessage)), MessageType::BearingChanged },
+		{ std::type_index(typeid(osmscout::StreetChangedMessage)), MessageType::StreetChanged },
+		{ std::type_index(typeid(osmscout::RouteStateChangedMessage)), MessageType::RouteStateChanged },
+	};
+
+	const auto type = types.find(std::type_index(typeid(message)));
+	return type != types.end() ? type->second : MessageType::Other;
+}
+
 Simulator::Simulator()
-	: routeState(osmscout::RouteStateChangedMessage::State::noRoute), _navigation(nullptr), _onRoute(false),
-	  _errorCount(0) {
+	: routeState(osmscout::RouteStateChangedMessage::State::noRoute), _onRoute(false),
+	  _gpxFileName("routeLife.gpx"), _console(std::cout.rdbuf()), _errorCount(0), _fixCount(0), _fixQualityFilter(false), _goodHdop(2.0), _maxHdop(10.0), _minSatellites(4), _lastAcceptedPosValid(false),
+	  _droppedFixes(0), _weightedFixes(0) {
 }
 
 Simulator::~Simulator() {
-	if(_streamGpxFile.is_open()) {
-		_streamGpxFile << "</gpx>" << std::endl;
-		_streamGpxFile.close();
+	_gpxWriter.Close();
+	_telemetry.Close();
+}
+
+void Simulator::SetFixQualityFilter(double goodHdop, double maxHdop, uint32_t minSatellites) {
+	_fixQualityFilter = true;
+	_goodHdop = goodHdop;
+	_maxHdop = maxHdop;
+	_minSatellites = minSatellites;
+}
+
+void Simulator::SetOutput(const std::string& gpxFileName, bool verbose) {
+	_gpxFileName = gpxFileName;
+	//Without a buffer the stream is bad and drops everything before formatting it
+	_console.rdbuf(verbose ? std::cout.rdbuf() : nullptr);
+}
+
+void Simulator::SetTelemetryFile(const std::string& telemetryFileName) {
+	_telemetryFileName = telemetryFileName;
+}
+
+size_t Simulator::GetFixCount() const {
+	return _fixCount;
+}
+
+const LatencyHistogram& Simulator::GetUpdateLatency() const {
+	return _updateLatency;
+}
+
+bool Simulator::FilterFix(const IPathGenerator::Step& step, osmscout::GeoCoord& coord) {
+	coord = step.coord;
+	if (!_fixQualityFilter) {
+		return true;
+	}
+
+	if (step.fixType == 1 ||
+		(step.satellites > 0 && step.satellites < _minSatellites) ||
+		(step.hdop > 0 && step.hdop > _maxHdop)) {
+		_droppedFixes++;
+		return false;
 	}
+
+	if (step.hdop > _goodHdop && _lastAcceptedPosValid) {
+		//Less trust, move only part of the way, a jumping fix in a street canyon costs a reroute
+		const auto weight = _goodHdop / step.hdop;
+		coord = osmscout::GeoCoord(
+			_lastAcceptedPos.GetLat() + (step.coord.GetLat() - _lastAcceptedPos.GetLat()) * weight,
+			_lastAcceptedPos.GetLon() + (step.coord.GetLon() - _lastAcceptedPos.GetLon()) * weight);
+		_weightedFixes++;
+	}
+
+	_lastAcceptedPos = coord;
+	_lastAcceptedPosValid = true;
+	return true;
 }
 
 void Simulator::ProcessMessages(const std::list<osmscout::NavigationMessageRef>& messages)
 {
 	for (const auto& message : messages) {
-		if (dynamic_cast<osmscout::PositionChangedMessage*>(message.get()) != nullptr) {
-			const auto positionChangedMessage=dynamic_cast<osmscout::PositionChangedMessage*>(message.get());
+		switch (ClassifyMessage(*message)) {
+		case MessageType::PositionChanged: {
+			const auto positionChangedMessage = static_cast<osmscout::PositionChangedMessage*>(message.get());
 			//std::cout << positionChangedMessage->currentPosition.GetDisplayText() <<  " Speed " << positionChangedMessage->currentSpeed << std::endl;
 			/*osmscout::ClosestRoutableObjectResult routableResult = router->GetClosestRoutableObject(location,
 				routingProfile->GetVehicle(),
 				osmscout::Distance::Of<osmscout::Meter>(100));*/
 			_lastGeopos = positionChangedMessage->currentPosition;
-			auto minDistance = 0.0;
-			auto result = _navigation.UpdateCurrentLocation(positionChangedMessage->currentPosition, minDistance);
-			const auto desc = _navigation.nextWaypointDescription();
+			//The matcher only looks ahead of the last match, the navigation moves to the segment it found
+			//instead of scanning the whole route for every fix
+			const auto match = _matcher->Update(positionChangedMessage->currentPosition);
+			auto minDistance = match.distance;
+			const auto result = _navigation.Update(match);
+			const auto desc = _navigation.NextWaypointDescription();
 			//std::cout << desc.distance.AsMeter() << std::endl;
 			auto distance = osmscout::GetEllipsoidalDistance(positionChangedMessage->currentPosition, desc.location);
 			const auto distanceInMeter = distance.As<osmscout::Meter>();
 			if (distanceInMeter <= 100 && _lastInstructions != desc.instructions) {
-				std::cout << "Distance to route: " << minDistance << " ?" << std::endl;
-				std::cout << "Distance to destination: " << _navigation.GetDistance().AsMeter() << std::endl;
-				std::cout << "Time to destination: " << TimeToString(_navigation.GetDuration()) << std::endl;
-				std::cout << "Next routing instructions: " << desc.instructions << std::endl;
+				_console << "Distance to route: " << minDistance << " m" << std::endl;
+				_console << "Distance to destination: " << _navigation.GetDistance().AsMeter() << std::endl;
+				_console << "Time to destination: " << TimeToString(_navigation.GetDuration()) << std::endl;
+				_console << "Next routing instructions: " << desc.instructions << std::endl;
+				_telemetry.Instruction(positionChangedMessage->timestamp, positionChangedMessage->currentPosition, desc.instructions);
 				_lastInstructions = desc.instructions;
 			}
 
 			if(result != _onRoute) {
 				if(result) {
-					std::cout << "route" << std::endl;
-					_streamGpxFile << "\t<wpt lat=\"" << desc.location.GetLat() << "\" lon=\"" << desc.location.GetLon() << "\">" << std::endl;
-					_streamGpxFile << "\t\t<name>Route found "<< std::to_string(_errorCount) << "</name>" << std::endl;
-					_streamGpxFile << "\t\t<fix>2d</fix>" << std::endl;
-					_streamGpxFile << "\t</wpt>" << std::endl;
-					_streamGpxFile << "\t<wpt lat=\"" << positionChangedMessage->currentPosition.GetLat() << "\" lon=\"" << positionChangedMessage->currentPosition.GetLon() << "\">" << std::endl;
-					_streamGpxFile << "\t\t<name>Car Point" << std::to_string(_errorCount) << "</name>" << std::endl;
-					_streamGpxFile << "\t\t<fix>2d</fix>" << std::endl;
-					_streamGpxFile << "\t</wpt>" << std::endl;
+					_console << "route" << std::endl;
+					_gpxWriter.Waypoint(desc.location, "Route found " + std::to_string(_errorCount));
+					_gpxWriter.Waypoint(positionChangedMessage->currentPosition, "Car Point" + std::to_string(_errorCount));
 				} else {
-					std::cout << "route verlassen" << std::endl;
-					_streamGpxFile << "\t<wpt lat=\"" << desc.location.GetLat() << "\" lon=\"" << desc.location.GetLon() << "\">" << std::endl;
-					_streamGpxFile << "\t\t<name>Route lost " << std::to_string(_errorCount) << "</name>" << std::endl;
-					_streamGpxFile << "\t\t<fix>2d</fix>" << std::endl;
-					_streamGpxFile << "\t</wpt>" << std::endl;
-					_streamGpxFile << "\t<wpt lat=\"" << positionChangedMessage->currentPosition.GetLat() << "\" lon=\"" << positionChangedMessage->currentPosition.GetLon() << "\">" << std::endl;
-					_streamGpxFile << "\t\t<name>Car Point" << std::to_string(_errorCount) << "</name>" << std::endl;
-					_streamGpxFile << "\t\t<fix>2d</fix>" << std::endl;
-					_streamGpxFile << "\t</wpt>" << std::endl;
+					_console << "route verlassen" << std::endl;
+					_gpxWriter.Waypoint(desc.location, "Route lost " + std::to_string(_errorCount));
+					_gpxWriter.Waypoint(positionChangedMessage->currentPosition, "Car Point" + std::to_string(_errorCount));
 				}
+				_telemetry.RouteState(positionChangedMessage->timestamp, positionChangedMessage->currentPosition, result);
 				_onRoute = result;
 				_errorCount++;
 			}
+			break;
 		}
-		if (dynamic_cast<osmscout::BearingChangedMessage*>(message.get()) != nullptr) {
-			const auto bearingChangedMessage = dynamic_cast<osmscout::BearingChangedMessage*>(message.get());
+		case MessageType::BearingChanged: {
+			const auto bearingChangedMessage = static_cast<osmscout::BearingChangedMessage*>(message.get());
 
 			auto bearingString = bearingChangedMessage->hasBearing ? osmscout::BearingDisplayString(bearingChangedMessage->bearing) : "";
 			if (lastBearingString != bearingString) {
-				std::cout << osmscout::TimestampToISO8601TimeString(bearingChangedMessage->timestamp)
+				_console << osmscout::TimestampToISO8601TimeString(bearingChangedMessage->timestamp)
 					<< " Bearing: " << bearingString << std::endl;
 
 				lastBearingString = bearingString;
 			}
+			break;
 		}
-		else if (dynamic_cast<osmscout::StreetChangedMessage*>(message.get()) != nullptr) {
-			auto streetChangedMessage = dynamic_cast<osmscout::StreetChangedMessage*>(message.get());
+		case MessageType::StreetChanged: {
+			auto streetChangedMessage = static_cast<osmscout::StreetChangedMessage*>(message.get());
 
-			std::cout << osmscout::TimestampToISO8601TimeString(streetChangedMessage->timestamp)
+			_console << osmscout::TimestampToISO8601TimeString(streetChangedMessage->timestamp)
 				<< " Street name: " << streetChangedMessage->name << std::endl;
 			
-			_streamGpxFile << "\t<wpt lat=\"" << _lastGeopos.GetLat() << "\" lon=\"" << _lastGeopos.GetLon() << "\">" << std::endl;
-			_streamGpxFile << "\t\t<name>Streetname (" << streetChangedMessage->name << ")" << std::to_string(_errorCount) << "</name>" << std::endl;
-			_streamGpxFile << "\t\t<fix>2d</fix>" << std::endl;
-			_streamGpxFile << "\t</wpt>" << std::endl;
+			_gpxWriter.Waypoint(_lastGeopos, "Streetname (" + streetChangedMessage->name + ")" + std::to_string(_errorCount));
+			_telemetry.StreetChanged(streetChangedMessage->timestamp, _lastGeopos, streetChangedMessage->name);
 
 			_errorCount++;
+			break;
 		}
-		else if (dynamic_cast<osmscout::RouteStateChangedMessage*>(message.get()) != nullptr) {
-			auto routeStateChangedMessage = dynamic_cast<osmscout::RouteStateChangedMessage*>(message.get());
+		case MessageType::RouteStateChanged: {
+			auto routeStateChangedMessage = static_cast<osmscout::RouteStateChangedMessage*>(message.get());
 
 			if (routeStateChangedMessage->state != routeState) {
 
 				routeState = routeStateChangedMessage->state;
 
 
-				std::cout << osmscout::TimestampToISO8601TimeString(routeStateChangedMessage->timestamp)
+				_console << osmscout::TimestampToISO8601TimeString(routeStateChangedMessage->timestamp)
 					<< " RouteState: ";
 
 				switch (routeState) {
 				case osmscout::RouteStateChangedMessage::State::noRoute:
-					std::cout << "no route";
+					_console << "no route";
 					break;
 				case osmscout::RouteStateChangedMessage::State::onRoute:
-					std::cout << "on route";
+					_console << "on route";
 					break;
 				case osmscout::RouteStateChangedMessage::State::offRoute:
-					std::cout << "off route";
+					_console << "off route";
 					break;
 				}
 
-				std::cout << std::endl;
+				_console << std::endl;
 			}
+			break;
+		}
+		case MessageType::Other:
+			break;
 		}
 	}
 }
@@ -137,6 +220,21 @@ void Simulator::Simulate(const osmscout::DatabaseRef& database,
 	const osmscout::RoutePointsRef& routePoints,
 	const osmscout::RouteDescriptionRef& description)
 {
+	TrackStepSource source(generator.steps);
+	Simulate(database, source, routePoints, description);
+}
+
+void Simulator::Simulate(const osmscout::DatabaseRef& database,
+	IStepSource& source,
+	const osmscout::RoutePointsRef& routePoints,
+	const osmscout::RouteDescriptionRef& description)
+{
+	IPathGenerator::Step step;
+	if (!source.NextStep(step)) {
+		std::cerr << "No steps to simulate" << std::endl;
+		return;
+	}
+
 	auto locationDescriptionService = std::make_shared<osmscout::LocationDescriptionService>(database);
 
 	routeState = osmscout::RouteStateChangedMessage::State::noRoute;
@@ -147,42 +245,77 @@ void Simulator::Simulate(const osmscout::DatabaseRef& database,
 	  std::make_shared<osmscout::RouteStateAgent>(),
 	};
 
-	const auto initializeMessage = std::make_shared<osmscout::InitializeMessage>(generator.steps.front().time);
+	const auto initializeMessage = std::make_shared<osmscout::InitializeMessage>(step.time);
+
+	_matcher.reset(new RouteMatcher(*description, SnapDistanceInMeter));
 
 	ProcessMessages(engine.Process(initializeMessage));
-	_navigation = new osmscout::NavigationDescription<osmscout::NodeDescription>;
-	_navigation.SetSnapDistance(osmscout::Distance::Of<osmscout::Meter>(100.0));
-	_navigation.SetRoute(description.get());
-
-	_streamGpxFile.open("routeLife.gpx", std::ofstream::trunc);
-	_streamGpxFile.precision(8);
-	_streamGpxFile << R"(<?xml version="1.0" encoding="UTF-8" standalone="no" ?>)" << std::endl;
-	_streamGpxFile << R"(<gpx xmlns="http://www.topografix.com/GPX/1/1" creator="TestNavLibOsmScout" version="0.1" xmlns:xsi="http://www.w3.org/2001/XMLSchema-instance" xsi:schemaLocation="http://www.topografix.com/GPX/1/1 http://www.topografix.com/GPX/1/1/gpx.xsd">)"
-		<< std::endl;
-
-	_streamGpxFile << "\t<wpt lat=\"" << generator.steps.front().coord.GetLat() << "\" lon=\"" << generator.steps.front().coord.GetLon() << "\">" << std::endl;
-	_streamGpxFile << "\t\t<name>Start</name>" << std::endl;
-	_streamGpxFile << "\t\t<fix>2d</fix>" << std::endl;
-	_streamGpxFile << "\t</wpt>" << std::endl;
-
-	_streamGpxFile << "\t<wpt lat=\"" << generator.steps.back().coord.GetLat() << "\" lon=\"" << generator.steps.back().coord.GetLon() << "\">" << std::endl;
-	_streamGpxFile << "\t\t<name>Target</name>" << std::endl;
-	_streamGpxFile << "\t\t<fix>2d</fix>" << std::endl;
-	_streamGpxFile << "\t</wpt>" << std::endl;
+	_navigation.SetRoute(description.get(), _matcher->GetTable());
+
+	if (!_gpxFileName.empty()) {
+		_gpxWriter.Open(_gpxFileName);
+	}
+	if (!_telemetryFileName.empty()) {
+		_telemetry.Open(_telemetryFileName);
+	}
+
+	_gpxWriter.Waypoint(step.coord, "Start");
+	_telemetry.Waypoint(step.coord, "Start");
 
 	// TODO: Simulator possibly should not send this message on start but later on to simulate driver starting before
 	// getting route
-	auto routeUpdateMessage = std::make_shared<osmscout::RouteUpdateMessage>(generator.steps.front().time, routePoints);
+	auto routeUpdateMessage = std::make_shared<osmscout::RouteUpdateMessage>(step.time, routePoints);
 
 	ProcessMessages(engine.Process(routeUpdateMessage));
 
-	for (const auto& point : generator.steps) {
-		auto gpsUpdateMessage = std::make_shared<osmscout::GPSUpdateMessage>(point.time, point.coord, point.speed);
+	// The steps are consumed as they come, the target is known after the last one
+	osmscout::GeoCoord lastCoord;
+	//Position for the navigation, differs from the step only with the fix quality filter
+	osmscout::GeoCoord navigationCoord;
+	_lastAcceptedPosValid = false;
+	_droppedFixes = 0;
+	_weightedFixes = 0;
+	_fixCount = 0;
+	do {
+		std::chrono::steady_clock::time_point arrival;
+		const auto hasArrival = source.GetArrivalTime(arrival);
+
+		if (!FilterFix(step, navigationCoord)) {
+			//The clock still goes on, only the position is not trusted
+			ProcessMessages(engine.Process(std::make_shared<osmscout::TimeTickMessage>(step.time)));
+			continue;
+		}
+
+		const auto updateStart = std::chrono::steady_clock::now();
+		auto gpsUpdateMessage = std::make_shared<osmscout::GPSUpdateMessage>(step.time, navigationCoord, step.speed);
 
 		ProcessMessages(engine.Process(gpsUpdateMessage));
 
-		auto timeTickMessage = std::make_shared<osmscout::TimeTickMessage>(point.time);
+		if (hasArrival) {
+			_latency.Add(std::chrono::steady_clock::now() - arrival);
+		}
+
+		auto timeTickMessage = std::make_shared<osmscout::TimeTickMessage>(step.time);
 
 		ProcessMessages(engine.Process(timeTickMessage));
+
+		_updateLatency.Add(std::chrono::steady_clock::now() - updateStart);
+		_fixCount++;
+		_telemetry.TrackPoint(step.time, step.coord, step.speed / 3.6);
+
+		lastCoord = step.coord;
+	} while (source.NextStep(step));
+
+	_gpxWriter.Waypoint(lastCoord, "Target");
+	_telemetry.Waypoint(lastCoord, "Target");
+
+	if (_droppedFixes > 0 || _weightedFixes > 0) {
+		_console << "Fixes dropped for low quality: " << _droppedFixes
+			<< ", down-weighted: " << _weightedFixes << std::endl;
+	}
+
+	if (_latency.GetCount() > 0) {
+		_console << "Sentence arrival to navigation output ";
+		_latency.Print(_console);
 	}
 }
\ No newline at end of file
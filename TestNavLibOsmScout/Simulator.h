@@ -1,27 +1,82 @@
 #pragma once
 #include <osmscout/navigation/Agents.h>
-#include "NavigationDescription.h"
-#include <fstream>
-class IPathGenerator;
+#include "LatencyHistogram.h"
+#include "IPathGenerator.h"
+#include "GpxWriter.h"
+#include "TelemetryLog.h"
+#include "RouteMatcher.h"
+#include "RouteNavigation.h"
+#include <memory>
+#include <ostream>
 class PathGenerator;
+class IStepSource;
 
 class Simulator
 {
 	osmscout::RouteStateChangedMessage::State routeState{};
 	std::string                               lastBearingString;
-	osmscout::Navigation<osmscout::NodeDescription> _navigation;
+	RouteNavigation _navigation;
 	std::string _lastInstructions;
 	bool _onRoute;
-	std::ofstream _streamGpxFile;
+	std::unique_ptr<RouteMatcher> _matcher;
+	GpxWriter _gpxWriter;
+	std::string _gpxFileName;
+	TelemetryWriter _telemetry;
+	std::string _telemetryFileName;
+	std::ostream _console;
 	int _errorCount;
 	osmscout::GeoCoord _lastGeopos;
+	LatencyHistogram _latency;
+	LatencyHistogram _updateLatency;
+	size_t _fixCount;
+	bool _fixQualityFilter;
+	double _goodHdop;
+	double _maxHdop;
+	uint32_t _minSatellites;
+	osmscout::GeoCoord _lastAcceptedPos;
+	bool _lastAcceptedPosValid;
+	size_t _droppedFixes;
+	size_t _weightedFixes;
 	void ProcessMessages(const std::list<osmscout::NavigationMessageRef>& messages);
+	bool FilterFix(const IPathGenerator::Step& step, osmscout::GeoCoord& coord);
 
 public:
 	Simulator();
 	~Simulator();
+	/**
+	 * Off by default, every fix reaches the navigation as it was decoded.
+	 * Once set, fixes without a fix, with less satellites or a HDOP above maxHdop never reach the navigation.
+	 * Between goodHdop and maxHdop the navigation gets the fix pulled to the last good position by goodHdop / hdop,
+	 * the gpx and telemetry track keep the fix as it was decoded.
+	 * Unknown quality (0) always passes.
+	 */
+	void SetFixQualityFilter(double goodHdop, double maxHdop, uint32_t minSatellites);
+	/**
+	 * Where the waypoints of the drive go, no file if gpxFileName is empty.
+	 * Without verbose nothing is written to the console.
+	 */
+	void SetOutput(const std::string& gpxFileName, bool verbose);
+	/**
+	 * The drive as binary telemetry log too, no file if telemetryFileName is empty (default)
+	 */
+	void SetTelemetryFile(const std::string& telemetryFileName);
+	/**
+	 * Fixes that reached the navigation engine in the last Simulate
+	 */
+	size_t GetFixCount() const;
+	/**
+	 * Time the navigation engine took for every fix, from the GPS update to the processed time tick
+	 */
+	const LatencyHistogram& GetUpdateLatency() const;
 	void Simulate(const osmscout::DatabaseRef& database,
 		const IPathGenerator& generator,
 		const osmscout::RoutePointsRef& routePoints,
 		const osmscout::RouteDescriptionRef& description);
+	/**
+	 * Every step goes to the navigation engine as soon as the source delivers it
+	 */
+	void Simulate(const osmscout::DatabaseRef& database,
+		IStepSource& source,
+		const osmscout::RoutePointsRef& routePoints,
+		const osmscout::RouteDescriptionRef& description);
 };
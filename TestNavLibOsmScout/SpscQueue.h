@@ -0,0 +1,62 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+
+/**
+ * Lock free ring of Capacity - 1 elements for exactly one producer and one consumer thread
+ */
+template<typename T, size_t Capacity>
+class SpscQueue
+{
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity has to be a power of two");
+
+	T                   _items[Capacity];
+	std::atomic<size_t> _head;   // next to pop, written by the consumer
+	std::atomic<size_t> _tail;   // next to push, written by the producer
+
+public:
+	SpscQueue()
+		: _items(),
+		_head(0),
+		_tail(0)
+	{
+		// no code
+	}
+
+	SpscQueue(const SpscQueue&) = delete;
+	SpscQueue& operator=(const SpscQueue&) = delete;
+
+	/**
+	 * @return false if the queue is full
+	 */
+	bool Push(const T& item)
+	{
+		const auto tail = _tail.load(std::memory_order_relaxed);
+		const auto next = (tail + 1) & (Capacity - 1);
+		if (next == _head.load(std::memory_order_acquire)) {
+			return false;
+		}
+		_items[tail] = item;
+		_tail.store(next, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * @return false if the queue is empty
+	 */
+	bool Pop(T& item)
+	{
+		const auto head = _head.load(std::memory_order_relaxed);
+		if (head == _tail.load(std::memory_order_acquire)) {
+			return false;
+		}
+		item = _items[head];
+		_head.store((head + 1) & (Capacity - 1), std::memory_order_release);
+		return true;
+	}
+
+	bool Empty() const
+	{
+		return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+	}
+};
@@ -0,0 +1,196 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include "TelemetryLog.h"
+
+static const char Magic[4] = { 'N', 'V', 'T', 'L' };
+static const uint32_t ByteOrderMark = 0x01020304;
+static const double CoordScale = 1e7;
+
+struct TelemetryHeader
+{
+	char     magic[4];
+	uint32_t version;
+	uint32_t byteOrder;
+	uint32_t flags;
+};
+
+//type, flags, payload length
+static const size_t RecordHeaderSize = 4;
+//time, lat, lon
+static const size_t PositionSize = sizeof(int64_t) + 2 * sizeof(int32_t);
+static const size_t MaxExtraSize = std::numeric_limits<uint16_t>::max() - PositionSize;
+
+static int64_t ToMilliseconds(const osmscout::Timestamp& time) {
+	return std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+}
+
+static int32_t ToE7(double degree) {
+	return static_cast<int32_t>(std::lround(degree * CoordScale));
+}
+
+bool TelemetryWriter::Open(const std::string& filename, size_t blockSize) {
+	Close();
+	if (!_writer.Open(filename, blockSize)) return false;
+
+	TelemetryHeader header;
+	std::memcpy(header.magic, Magic, sizeof(Magic));
+	header.version = Version;
+	header.byteOrder = ByteOrderMark;
+	header.flags = 0;
+	_writer.Write(reinterpret_cast<const char*>(&header), sizeof(header));
+	return true;
+}
+
+bool TelemetryWriter::Close() {
+	return _writer.Close();
+}
+
+void TelemetryWriter::Record(uint8_t type, uint8_t flags, int64_t time, const osmscout::GeoCoord& coord,
+	const void* extra, size_t extraSize) {
+	if (!_writer.IsOpen()) return;
+
+	extraSize = std::min(extraSize, MaxExtraSize);
+	const auto length = static_cast<uint16_t>(PositionSize + extraSize);
+	const auto lat = ToE7(coord.GetLat());
+	const auto lon = ToE7(coord.GetLon());
+
+	auto out = _writer.Reserve(RecordHeaderSize + PositionSize);
+	if (out == nullptr) return;
+	out[0] = static_cast<char>(type);
+	out[1] = static_cast<char>(flags);
+	std::memcpy(out + 2, &length, sizeof(length));
+	std::memcpy(out + RecordHeaderSize, &time, sizeof(time));
+	std::memcpy(out + RecordHeaderSize + sizeof(time), &lat, sizeof(lat));
+	std::memcpy(out + RecordHeaderSize + sizeof(time) + sizeof(lat), &lon, sizeof(lon));
+	_writer.Commit(RecordHeaderSize + PositionSize);
+
+	if (extraSize > 0) {
+		_writer.Write(static_cast<const char*>(extra), extraSize);
+	}
+}
+
+void TelemetryWriter::Waypoint(const osmscout::GeoCoord& coord, const std::string& name) {
+	Record(TelemetryRecord::Waypoint, 0, 0, coord, name.data(), name.size());
+}
+
+void TelemetryWriter::RoutePoint(const osmscout::GeoCoord& coord) {
+	Record(TelemetryRecord::RoutePoint, 0, 0, coord, nullptr, 0);
+}
+
+void TelemetryWriter::TrackPoint(const osmscout::Timestamp& time, const osmscout::GeoCoord& coord, double speed) {
+	const auto speedValue = static_cast<float>(speed);
+	Record(TelemetryRecord::TrackPoint, 0, ToMilliseconds(time), coord, &speedValue, sizeof(speedValue));
+}
+
+void TelemetryWriter::RouteState(const osmscout::Timestamp& time, const osmscout::GeoCoord& coord, bool onRoute) {
+	Record(TelemetryRecord::RouteState, onRoute ? TelemetryRecord::OnRoute : 0, ToMilliseconds(time), coord, nullptr, 0);
+}
+
+void TelemetryWriter::StreetChanged(const osmscout::Timestamp& time, const osmscout::GeoCoord& coord, const std::string& name) {
+	Record(TelemetryRecord::StreetChanged, 0, ToMilliseconds(time), coord, name.data(), name.size());
+}
+
+void TelemetryWriter::Instruction(const osmscout::Timestamp& time, const osmscout::GeoCoord& coord, const std::string& instruction) {
+	Record(TelemetryRecord::Instruction, 0, ToMilliseconds(time), coord, instruction.data(), instruction.size());
+}
+
+TelemetryReader::TelemetryReader():
+	_position(nullptr),
+	_end(nullptr),
+	_truncated(false) {
+}
+
+bool TelemetryReader::Open(const std::string& filename) {
+	//Nothing of an earlier file stays readable if this one fails
+	_position = nullptr;
+	_end = nullptr;
+	_truncated = false;
+
+	if (!_file.Open(filename)) return false;
+	if (_file.Size() < sizeof(TelemetryHeader)) {
+		_file.Close();
+		return false;
+	}
+
+	TelemetryHeader header;
+	std::memcpy(&header, _file.Data(), sizeof(header));
+	if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 ||
+		header.version != TelemetryWriter::Version ||
+		header.byteOrder != ByteOrderMark) {
+		_file.Close();
+		return false;
+	}
+
+	Rewind();
+	return true;
+}
+
+void TelemetryReader::Rewind() {
+	if (!_file.IsOpen()) return;
+
+	_position = _file.Data() + sizeof(TelemetryHeader);
+	_end = _file.Data() + _file.Size();
+	_truncated = false;
+}
+
+bool TelemetryReader::Next(TelemetryRecord& record) {
+	if (!_file.IsOpen() || _position == nullptr) return false;
+
+	const auto available = static_cast<size_t>(_end - _position);
+	if (available < RecordHeaderSize) {
+		_truncated = available > 0;
+		return false;
+	}
+
+	uint16_t length;
+	std::memcpy(&length, _position + 2, sizeof(length));
+	if (available - RecordHeaderSize < length) {
+		_truncated = true;
+		return false;
+	}
+
+	const auto payload = _position + RecordHeaderSize;
+	record.type = static_cast<uint8_t>(_position[0]);
+	record.flags = static_cast<uint8_t>(_position[1]);
+	record.time = 0;
+	record.lat = 0.0;
+	record.lon = 0.0;
+	record.speed = 0.0;
+	record.text.clear();
+	_position = payload + length;
+
+	if (length < PositionSize) {
+		return true;
+	}
+
+	int32_t lat;
+	int32_t lon;
+	std::memcpy(&record.time, payload, sizeof(record.time));
+	std::memcpy(&lat, payload + sizeof(record.time), sizeof(lat));
+	std::memcpy(&lon, payload + sizeof(record.time) + sizeof(lat), sizeof(lon));
+	record.lat = lat / CoordScale;
+	record.lon = lon / CoordScale;
+
+	const auto extra = payload + PositionSize;
+	const auto extraSize = length - PositionSize;
+	switch (record.type) {
+	case TelemetryRecord::TrackPoint:
+		if (extraSize >= sizeof(float)) {
+			float speed;
+			std::memcpy(&speed, extra, sizeof(speed));
+			record.speed = speed;
+		}
+		break;
+	case TelemetryRecord::Waypoint:
+	case TelemetryRecord::StreetChanged:
+	case TelemetryRecord::Instruction:
+		record.text.assign(extra, extraSize);
+		break;
+	default:
+		break;
+	}
+	return true;
+}
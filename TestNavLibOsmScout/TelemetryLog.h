@@ -0,0 +1,108 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <osmscout/GeoCoord.h>
+#include "AsyncFileWriter.h"
+#include "MappedFile.h"
+
+/**
+ * Binary log of a simulation, the compact sibling of the GPX files.
+ * A header (magic, version, byte order mark) and then length prefixed records in the byte order
+ * of the writer: type (uint8), flags (uint8), payload length (uint16), payload.
+ * Every payload starts with time in ms since 1970 (int64) and lat/lon in 1e-7 degree (int32),
+ * track points add the speed in m/s (float), waypoints, street changes and instructions add their text.
+ * Readers skip record types they don't know.
+ */
+struct TelemetryRecord
+{
+	enum Type : uint8_t
+	{
+		Waypoint = 1,
+		RoutePoint = 2,
+		TrackPoint = 3,
+		RouteState = 4,     // flags OnRoute if the vehicle got back on the route
+		StreetChanged = 5,
+		Instruction = 6
+	};
+
+	static const uint8_t OnRoute = 1;
+
+	uint8_t     type;
+	uint8_t     flags;
+	int64_t     time;     // ms since 1970 UTC, 0 for waypoints and route points
+	double      lat;
+	double      lon;
+	double      speed;    // m/s
+	std::string text;
+
+	TelemetryRecord()
+		: type(0),
+		flags(0),
+		time(0),
+		lat(0.0),
+		lon(0.0),
+		speed(0.0)
+	{
+		// no code
+	}
+
+	osmscout::Timestamp GetTimestamp() const
+	{
+		return osmscout::Timestamp(std::chrono::duration_cast<osmscout::Timestamp::duration>(std::chrono::milliseconds(time)));
+	}
+};
+
+class TelemetryWriter
+{
+	AsyncFileWriter _writer;
+
+	void Record(uint8_t type, uint8_t flags, int64_t time, const osmscout::GeoCoord& coord,
+		const void* extra, size_t extraSize);
+
+public:
+	static const uint32_t Version = 1;
+
+	bool Open(const std::string& filename, size_t blockSize = AsyncFileWriter::DefaultBlockSize);
+	bool Close();
+	bool IsOpen() const
+	{
+		return _writer.IsOpen();
+	}
+
+	void Waypoint(const osmscout::GeoCoord& coord, const std::string& name);
+	void RoutePoint(const osmscout::GeoCoord& coord);
+	void TrackPoint(const osmscout::Timestamp& time, const osmscout::GeoCoord& coord, double speed);
+	void RouteState(const osmscout::Timestamp& time, const osmscout::GeoCoord& coord, bool onRoute);
+	void StreetChanged(const osmscout::Timestamp& time, const osmscout::GeoCoord& coord, const std::string& name);
+	void Instruction(const osmscout::Timestamp& time, const osmscout::GeoCoord& coord, const std::string& instruction);
+};
+
+class TelemetryReader
+{
+	MappedFile  _file;
+	const char* _position;
+	const char* _end;
+	bool        _truncated;
+
+public:
+	TelemetryReader();
+
+	/**
+	 * @return false if it is no telemetry log of this version and byte order, Next then returns false too
+	 */
+	bool Open(const std::string& filename);
+	/**
+	 * Start again with the first record
+	 */
+	void Rewind();
+	bool Next(TelemetryRecord& record);
+	/**
+	 * The last record was cut off, the writer didn't finish the file
+	 */
+	bool IsTruncated() const
+	{
+		return _truncated;
+	}
+};
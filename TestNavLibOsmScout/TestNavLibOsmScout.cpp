@@ -1,4 +1,6 @@
 ﻿#include <chrono>
+#include <cstdlib>
+#include <memory>
 #include <thread>
 
 #include <osmscout/Database.h>
@@ -10,7 +12,13 @@
 #include "ConsoleRoutingProgress.h"
 #include "PathGenerator.h"
 #include "Simulator.h"
+#include "FleetSimulator.h"
+#include "GpxWriter.h"
+#include "TelemetryLog.h"
 #include "PathGeneratorNMEA.h"
+#include "NMEALogFile.h"
+#include "NMEAStepSource.h"
+#include "LiveNMEASource.h"
 
 struct RouteDescriptionGeneratorCallback : public osmscout::RouteDescriptionGenerator::Callback
 {
@@ -39,126 +47,94 @@ static void GetCarSpeedTable(std::map<std::string, double>& map)
 	map["highway_service"] = 30.0;
 }
 
-bool GetFirstPosInFile(const std::string& nmeaFilename, double& startLat, double& startLon) {
-	NMEADecoder decoder;
-
-	std::ifstream file(nmeaFilename);
-	if (!file.is_open()) {
-		LOG(ERROR) << "Error Open File";
-		std::cout << "Error Open File";
-		return false;
-	}
-
-	std::string line;
-	while (std::getline(file, line)) {
-		if (decoder.Decode(line)) {
-			//LOG(DEBUG) << "Line Read and decode " << line;
-			if (decoder.IsPositionValid()) {
-				startLat = decoder.GetLatitude();
-				startLon = decoder.GetLongitude();
-				return true;
-			}
-		}
-	}
-	return false;
+static void PrintUsage()
+{
+	std::cout << "Please Call TestNavLibOsmScout <map directory> <nmeafile> [--stream [<target lat> <target lon>]] [--drive [tick rate]] [--fleet <vehicles> [threads]] [--filter] [--format gpx|telemetry|both]" << std::endl;
+	std::cout << "or TestNavLibOsmScout <map directory> <gps device> --live <target lat> <target lon>" << std::endl;
 }
 
-bool GetLastPosInFile(const std::string& nmeaFilename,const double& startLat, const double& startLon, double& targetLat, double& targetLon) {
-	//Todo find faster way
-
-	std::ifstream file(nmeaFilename);
-	if (!file.is_open()) {
-		LOG(ERROR) << "Error Open File";
-		std::cout << "Error Open File";
-		return false;
-	}
+/**
+ * Degrees from the command line, false if text is no number or beyond limit
+ */
+static bool ParseCoordinate(const char* text, double limit, double& value)
+{
+	char* end = nullptr;
+	const auto parsed = std::strtod(text, &end);
+	if (end == text || *end != '\0' || parsed < -limit || parsed > limit) return false;
 
-	NMEADecoder decoder;
-	std::string line;
-
-	auto result = false;
-	auto distanceInKilometerLast = 0.0;
-	osmscout::GeoCoord startPos(startLat, startLon);
-	while (std::getline(file, line)) {
-		if (decoder.Decode(line)) {
-			//LOG(DEBUG) << "Line Read and decode " << line;
-			if (decoder.IsPositionValid()) {
-				const auto curtargetLat = decoder.GetLatitude();
-				const auto curtargetLon = decoder.GetLongitude();
-				const osmscout::GeoCoord currentPos(curtargetLat, curtargetLon);
-				if (startPos.GetLat() != 0) {
-					auto distance = osmscout::GetEllipsoidalDistance(currentPos, startPos);
-					const auto distanceInKilometer = distance.As<osmscout::Kilometer>();
-					if(distanceInKilometer > distanceInKilometerLast) {
-						distanceInKilometerLast = distanceInKilometer;
-						targetLat = curtargetLat;
-						targetLon = curtargetLon;
-						result = true;
-					}
-				}
-				
-			}
-		}
-	}
-	return result;
+	value = parsed;
+	return true;
 }
 
 void DumpGpxFile(const std::string& fileName,
 	const std::vector<osmscout::Point>& points,
 	const IPathGenerator& generator)
 {
-	std::ofstream stream;
+	GpxWriter writer;
 
 	std::cout << "Writing gpx file '" << fileName << "'..." << std::endl;
 
-	stream.open(fileName, std::ofstream::trunc);
-
-	if (!stream.is_open()) {
+	//Big blocks, a day long track is some hundred MB
+	if (!writer.Open(fileName, 1024 * 1024)) {
 		std::cerr << "Cannot open gpx file!" << std::endl;
 		return;
 	}
 
-	stream.precision(8);
-	stream << R"(<?xml version="1.0" encoding="UTF-8" standalone="no" ?>)" << std::endl;
-	stream << R"(<gpx xmlns="http://www.topografix.com/GPX/1/1" creator="TestNavLibOsmScout" version="0.1" xmlns:xsi="http://www.w3.org/2001/XMLSchema-instance" xsi:schemaLocation="http://www.topografix.com/GPX/1/1 http://www.topografix.com/GPX/1/1/gpx.xsd">)"
-		<< std::endl;
+	writer.Waypoint(generator.steps.front().coord, "Start");
+	writer.Waypoint(generator.steps.back().coord, "Target");
+
+	writer.BeginRoute("Route");
+	for (const auto& point : points) {
+		writer.RoutePoint(point.GetLat(), point.GetLon());
+	}
+	writer.EndRoute();
+
+	writer.BeginTrack("GPS");
+	const auto& steps = generator.steps;
+	for (size_t index = 0; index < steps.size(); index++) {
+		writer.TrackPoint(steps.lats()[index], steps.lons()[index], steps.time(index), steps.speed(index) / 3.6);
+	}
+	writer.EndTrack();
 
-	stream << "\t<wpt lat=\"" << generator.steps.front().coord.GetLat() << "\" lon=\"" << generator.steps.front().coord.GetLon() << "\">" << std::endl;
-	stream << "\t\t<name>Start</name>" << std::endl;
-	stream << "\t\t<fix>2d</fix>" << std::endl;
-	stream << "\t</wpt>" << std::endl;
+	if (!writer.Close()) {
+		std::cerr << "Cannot write gpx file!" << std::endl;
+		return;
+	}
 
-	stream << "\t<wpt lat=\"" << generator.steps.back().coord.GetLat() << "\" lon=\"" << generator.steps.back().coord.GetLon() << "\">" << std::endl;
-	stream << "\t\t<name>Target</name>" << std::endl;
-	stream << "\t\t<fix>2d</fix>" << std::endl;
-	stream << "\t</wpt>" << std::endl;
+	std::cout << "Writing gpx file done." << std::endl;
+}
+
+void DumpTelemetryFile(const std::string& fileName,
+	const std::vector<osmscout::Point>& points,
+	const IPathGenerator& generator)
+{
+	TelemetryWriter writer;
+
+	std::cout << "Writing telemetry file '" << fileName << "'..." << std::endl;
+
+	if (!writer.Open(fileName, 1024 * 1024)) {
+		std::cerr << "Cannot open telemetry file!" << std::endl;
+		return;
+	}
+
+	writer.Waypoint(generator.steps.front().coord, "Start");
+	writer.Waypoint(generator.steps.back().coord, "Target");
 
-	stream << "\t<rte>" << std::endl;
-	stream << "\t\t<name>Route</name>" << std::endl;
 	for (const auto& point : points) {
-		stream << "\t\t\t<rtept lat=\"" << point.GetLat() << "\" lon=\"" << point.GetLon() << "\">" << std::endl;
-		stream << "\t\t\t</rtept>" << std::endl;
+		writer.RoutePoint(point.GetCoord());
 	}
-	stream << "\t</rte>" << std::endl;
-
-	stream << "\t<trk>" << std::endl;
-	stream << "\t\t<name>GPS</name>" << std::endl;
-	stream << "\t\t<number>1</number>" << std::endl;
-	stream << "\t\t<trkseg>" << std::endl;
-	for (const auto& point : generator.steps) {
-		stream << "\t\t\t<trkpt lat=\"" << point.coord.GetLat() << "\" lon=\"" << point.coord.GetLon() << "\">" << std::endl;
-		stream << "\t\t\t\t<time>" << osmscout::TimestampToISO8601TimeString(point.time) << "</time>" << std::endl;
-		stream << "\t\t\t\t<speed>" << point.speed / 3.6 << "</speed>" << std::endl;
-		stream << "\t\t\t\t<fix>2d</fix>" << std::endl;
-		stream << "\t\t\t</trkpt>" << std::endl;
+
+	const auto& steps = generator.steps;
+	for (size_t index = 0; index < steps.size(); index++) {
+		writer.TrackPoint(steps.time(index), osmscout::GeoCoord(steps.lats()[index], steps.lons()[index]), steps.speed(index) / 3.6);
 	}
-	stream << "\t\t</trkseg>" << std::endl;
-	stream << "\t</trk>" << std::endl;
-	stream << "</gpx>" << std::endl;
 
-	stream.close();
+	if (!writer.Close()) {
+		std::cerr << "Cannot write telemetry file!" << std::endl;
+		return;
+	}
 
-	std::cout << "Writing gpx file done." << std::endl;
+	std::cout << "Writing telemetry file done." << std::endl;
 }
 
 INITIALIZE_EASYLOGGINGPP
@@ -168,18 +144,96 @@ int main(int argc, char *argv[])
 	//Todo put it to commandLine
 	std::string gpxFile = "routeRouter.gpx";
 	std::string gpxFileTour = "routeTour.gpx";
+	std::string gpxFileLife = "routeLife.gpx";
+	//Binary siblings of the gpx files, see TelemetryLog.h
+	std::string telemetryFile;
+	std::string telemetryFileTour;
+	std::string telemetryFileLife;
 
 	START_EASYLOGGINGPP(argc, argv);
 
 	std::string mapDirectory;
 	std::string nmeaFile;
+	//Decode the log while simulating, the steps are never all in memory
+	auto streamSteps = false;
+	//The nmea file is a GPS receiver (serial port, pty or fifo), the target comes from the command line
+	auto liveInput = false;
 
 	std::cout << "Hello we tray test LibOsmScout Navi Class" << std::endl;
+	//Route track with acceleration and braking, the tick rate in Hz may follow
+	auto driveRoute = false;
+	PathGenerator::DrivingModel drivingModel;
+	//Load test with many vehicles on the route track instead of the single drive
+	size_t fleetVehicles = 0;
+	size_t fleetThreads = std::thread::hardware_concurrency();
+	//Drop and down-weight fixes of low quality before the navigation, see Simulator::SetFixQualityFilter
+	auto fixQualityFilter = false;
+	//50.408889 9.367222 50.2741053 9.3721825
+	double startLat = 50.41016;
+	double startLon = 9.36519;
+	double targetLat = 50.27399;
+	double targetLon = 9.37022;
+	auto targetGiven = false;
+	auto badArguments = false;
+	for (int i = 3; i < argc; i++) {
+		//The target may follow, without it the whole log is decoded for the farthest fix first
+		if (std::string(argv[i]) == "--stream") {
+			streamSteps = true;
+			if (i + 1 < argc && ParseCoordinate(argv[i + 1], 90.0, targetLat)) {
+				targetGiven = true;
+				if (i + 2 >= argc || !ParseCoordinate(argv[i + 2], 180.0, targetLon)) {
+					std::cerr << "--stream needs the target longitude after the latitude" << std::endl;
+					badArguments = true;
+				}
+			}
+		}
+		if (std::string(argv[i]) == "--live") {
+			liveInput = true;
+			if (i + 2 >= argc ||
+				!ParseCoordinate(argv[i + 1], 90.0, targetLat) ||
+				!ParseCoordinate(argv[i + 2], 180.0, targetLon)) {
+				std::cerr << "--live needs the target latitude and longitude" << std::endl;
+				badArguments = true;
+			}
+		}
+		if (std::string(argv[i]) == "--drive") {
+			driveRoute = true;
+			if (i + 1 < argc && std::atof(argv[i + 1]) > 0) {
+				drivingModel.tickRate = std::atof(argv[i + 1]);
+			}
+		}
+		if (std::string(argv[i]) == "--fleet" && i + 1 < argc) {
+			fleetVehicles = std::strtoul(argv[i + 1], nullptr, 10);
+			if (i + 2 < argc && std::strtoul(argv[i + 2], nullptr, 10) > 0) {
+				fleetThreads = std::strtoul(argv[i + 2], nullptr, 10);
+			}
+		}
+		if (std::string(argv[i]) == "--filter") {
+			fixQualityFilter = true;
+		}
+		//gpx (default), telemetry or both
+		if (std::string(argv[i]) == "--format" && i + 1 < argc) {
+			const std::string format = argv[i + 1];
+			if (format == "telemetry" || format == "both") {
+				telemetryFile = "routeRouter.navt";
+				telemetryFileTour = "routeTour.navt";
+				telemetryFileLife = "routeLife.navt";
+			}
+			if (format == "telemetry") {
+				gpxFile.clear();
+				gpxFileTour.clear();
+				gpxFileLife.clear();
+			}
+		}
+	}
 	if(argc < 3) {
 		std::cout << "Missing commandline Parameters" << std::endl;
-		std::cout << "Please Call TestNavLibOsmScout <map directory> <nmeafile>" << std::endl;
+		PrintUsage();
 		mapDirectory = "/home/punky/develop/libosmscout-code/maps/hessen-latest";
 		nmeaFile = "/home/punky/develop/GPS-Adnan-Tour.txt";
+	} else if (badArguments) {
+		PrintUsage();
+		return -1;
 	} else {
 		mapDirectory = argv[1];
 		nmeaFile = argv[2];
@@ -217,15 +271,64 @@ int main(int argc, char *argv[])
 		carSpeedTable,
 		160.0);
 
-	//50.408889 9.367222 50.2741053 9.3721825
-	double startLat = 50.41016;
-	double startLon = 9.36519;
-	double targetLat = 50.27399;
-	double targetLon = 9.37022;
+	NMEALogFile nmeaLog;
+	PathGeneratorNMEA pathGenerator2(nmeaLog, routingProfile->GetVehicleMaxSpeed());
+	LiveNMEASource liveSource;
+	std::unique_ptr<NMEAStepSource> stepSource;
+
+	if (liveInput) {
+		if (!liveSource.Open(nmeaFile)) {
+			std::cerr << "Cannot open gps device" << std::endl;
+			return -13;
+		}
+
+		std::cout << "Wait for the first fix" << std::endl;
+		IPathGenerator::Step firstStep;
+		if (!liveSource.PeekStep(firstStep)) {
+			std::cerr << "Cannot get a start pos from gps device" << std::endl;
+			return -4;
+		}
+		startLat = firstStep.coord.GetLat();
+		startLon = firstStep.coord.GetLon();
+	} else {
+		if (!nmeaLog.Open(nmeaFile)) {
+			std::cerr << "Cannot open nmea file" << std::endl;
+			return -12;
+		}
+
+		if (streamSteps) {
+			//The start is the first fix, only its batch is decoded before the route
+			stepSource.reset(new NMEAStepSource(nmeaLog));
+			IPathGenerator::Step firstStep;
+			if (!stepSource->PeekStep(firstStep)) {
+				std::cerr << "Cannot finde a start pos in file" << std::endl;
+				return -4;
+			}
+			startLat = firstStep.coord.GetLat();
+			startLon = firstStep.coord.GetLon();
+
+			//Without a target the whole log is decoded once before the first output
+			if (!targetGiven) {
+				pathGenerator2.FindFirstAndFarthestPos();
+				if (!pathGenerator2.GetFarthestPos(targetLat, targetLon)) {
+					std::cerr << "Cannot finde a last pos in file" << std::endl;
+					return -6;
+				}
+			}
+		} else {
+			//One pass for start, target and the steps of the tour
+			pathGenerator2.LoadOrGenerateSteps(std::thread::hardware_concurrency());
 
-	if (!GetFirstPosInFile(nmeaFile, startLat, startLon)) {
-		std::cerr << "Cannot finde a start pos in file" << std::endl;
-		return -4;
+			if (!pathGenerator2.GetFirstPos(startLat, startLon)) {
+				std::cerr << "Cannot finde a start pos in file" << std::endl;
+				return -4;
+			}
+
+			if (!pathGenerator2.GetFarthestPos(targetLat, targetLon)) {
+				std::cerr << "Cannot finde a last pos in file" << std::endl;
+				return -6;
+			}
+		}
 	}
 
 	auto startCoord = osmscout::GeoCoord(startLat, startLon);
@@ -243,11 +346,6 @@ int main(int argc, char *argv[])
 	if (start.GetObjectFileRef().GetType() == osmscout::refNode) {
 		std::cerr << "Cannot find start node for start location!" << std::endl;
 	}
-	
-	if (!GetLastPosInFile(nmeaFile, startLat, startLon, targetLat, targetLon)) {
-		std::cerr << "Cannot finde a last pos in file" << std::endl;
-		return -6;
-	}
 
 	auto targetCoord = osmscout::GeoCoord(targetLat, targetLon);
 	std::cout << targetCoord.GetDisplayText() << std::endl;
@@ -349,10 +447,9 @@ int main(int argc, char *argv[])
 	std::cout << "Description generation time: " << generateTimer.ResultString() << std::endl;
 	
 
-	PathGenerator pathGenerator(*routeDescriptionResult.description, routingProfile->GetVehicleMaxSpeed());
-
-	PathGeneratorNMEA pathGenerator2(nmeaFile, routingProfile->GetVehicleMaxSpeed());
-	pathGenerator2.GenerateSteps();
+	PathGenerator pathGenerator = driveRoute ?
+		PathGenerator(*routeDescriptionResult.description, routingProfile->GetVehicleMaxSpeed(), drivingModel) :
+		PathGenerator(*routeDescriptionResult.description, routingProfile->GetVehicleMaxSpeed());
 
 	if (!gpxFile.empty()) {
 		DumpGpxFile(gpxFile,
@@ -360,18 +457,57 @@ int main(int argc, char *argv[])
 			pathGenerator);
 	}
 
-	if (!gpxFileTour.empty()) {
+	if (!gpxFileTour.empty() && !streamSteps && !liveInput) {
 		DumpGpxFile(gpxFileTour,
 			routePointsResult.points->points,
 			pathGenerator2);
 	}
 
+	if (!telemetryFile.empty()) {
+		DumpTelemetryFile(telemetryFile,
+			routePointsResult.points->points,
+			pathGenerator);
+	}
+
+	if (!telemetryFileTour.empty() && !streamSteps && !liveInput) {
+		DumpTelemetryFile(telemetryFileTour,
+			routePointsResult.points->points,
+			pathGenerator2);
+	}
+
+	if (fleetVehicles > 0) {
+		FleetSimulator fleet;
+		fleet.AddRoute(routePointsResult.points, routeDescriptionResult.description, pathGenerator);
+		fleet.Run(database, fleetVehicles, fleetThreads);
+
+		router->Close();
+
+		return 0;
+	}
+
 	Simulator simulator;
+	simulator.SetOutput(gpxFileLife, true);
+	simulator.SetTelemetryFile(telemetryFileLife);
+	if (fixQualityFilter) {
+		simulator.SetFixQualityFilter(2.0, 10.0, 4);
+	}
 
-	simulator.Simulate(database,
-		pathGenerator2,
-		routePointsResult.points,
-		routeDescriptionResult.description);
+	if (liveInput) {
+		simulator.Simulate(database,
+			liveSource,
+			routePointsResult.points,
+			routeDescriptionResult.description);
+	} else if (streamSteps) {
+		simulator.Simulate(database,
+			*stepSource,
+			routePointsResult.points,
+			routeDescriptionResult.description);
+	} else {
+		simulator.Simulate(database,
+			pathGenerator2,
+			routePointsResult.points,
+			routeDescriptionResult.description);
+	}
 
 	router->Close();
 
@@ -0,0 +1,191 @@
+#include "TrackCache.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+#include "utils/easylogging++.h"
+#include "MappedFile.h"
+
+static const char Magic[4] = { 'N', 'M', 'T', 'C' };
+static const uint32_t ByteOrderMark = 0x01020304;
+static const double CoordScale = 1e7;
+static const double SpeedScale = 100.0;
+static const double HdopScale = 100.0;
+
+struct TrackCacheHeader
+{
+	char     magic[4];
+	uint32_t version;
+	uint32_t byteOrder;
+	uint32_t flags;
+	uint64_t sourceSize;
+	int64_t  sourceModified;  // ns since 1970, 100 ns since 1601 on Windows
+	uint64_t count;
+	double   firstLat;
+	double   firstLon;
+	double   farthestLat;
+	double   farthestLon;
+};
+
+static_assert(sizeof(TrackCacheHeader) % 8 == 0, "columns must stay aligned");
+
+//time, lat, lon, speed, hdop, satellites, fix type
+static const size_t RowSize = sizeof(int64_t) + 2 * sizeof(int32_t) + 2 * sizeof(uint16_t) + 2 * sizeof(uint8_t);
+
+static const uint32_t FlagFirstPos = 1;
+static const uint32_t FlagFarthestPos = 2;
+
+//Seconds are too coarse, a log rewritten in the same second with the same size would
+//still match its old cache
+static bool GetSourceInfo(const std::string& filename, uint64_t& size, int64_t& modified) {
+#ifdef _WIN32
+	WIN32_FILE_ATTRIBUTE_DATA info;
+	if (!GetFileAttributesExA(filename.c_str(), GetFileExInfoStandard, &info)) return false;
+	size = (static_cast<uint64_t>(info.nFileSizeHigh) << 32) | info.nFileSizeLow;
+	modified = static_cast<int64_t>((static_cast<uint64_t>(info.ftLastWriteTime.dwHighDateTime) << 32) | info.ftLastWriteTime.dwLowDateTime);
+#else
+	struct stat info;
+	if (stat(filename.c_str(), &info) != 0) return false;
+	size = static_cast<uint64_t>(info.st_size);
+#ifdef __APPLE__
+	const auto& modifiedTime = info.st_mtimespec;
+#else
+	const auto& modifiedTime = info.st_mtim;
+#endif
+	modified = static_cast<int64_t>(modifiedTime.tv_sec) * 1000000000 + modifiedTime.tv_nsec;
+#endif
+	return true;
+}
+
+std::string TrackCache::GetCacheFilename(const std::string& sourceFilename) {
+	return sourceFilename + ".trackcache";
+}
+
+bool TrackCache::Load(const std::string& sourceFilename, IPathGenerator::StepTrack& steps, TrackCacheInfo& info) {
+	uint64_t sourceSize;
+	int64_t sourceModified;
+	if (!GetSourceInfo(sourceFilename, sourceSize, sourceModified)) return false;
+
+	MappedFile file;
+	if (!file.Open(GetCacheFilename(sourceFilename))) return false;
+	if (file.Size() < sizeof(TrackCacheHeader)) return false;
+
+	TrackCacheHeader header;
+	std::memcpy(&header, file.Data(), sizeof(header));
+	if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 ||
+		header.version != Version ||
+		header.byteOrder != ByteOrderMark) {
+		LOG(INFO) << "Track cache has an other format, rebuild it";
+		return false;
+	}
+	if (header.sourceSize != sourceSize || header.sourceModified != sourceModified) {
+		LOG(INFO) << "Track cache is older than the log, rebuild it";
+		return false;
+	}
+
+	//Divided, the product of an untrusted count can overflow
+	if (header.count > (file.Size() - sizeof(TrackCacheHeader)) / RowSize) {
+		LOG(WARNING) << "Track cache is truncated";
+		return false;
+	}
+	const auto count = static_cast<size_t>(header.count);
+
+	//Header size is a multiple of 8, the columns are aligned in the mapping
+	const auto times = reinterpret_cast<const int64_t*>(file.Data() + sizeof(TrackCacheHeader));
+	const auto lats = reinterpret_cast<const int32_t*>(times + count);
+	const auto lons = lats + count;
+	const auto speeds = reinterpret_cast<const uint16_t*>(lons + count);
+	const auto hdops = speeds + count;
+	const auto satellites = reinterpret_cast<const uint8_t*>(hdops + count);
+	const auto fixTypes = satellites + count;
+
+	steps.clear();
+	steps.reserve(count);
+	for (size_t i = 0; i < count; i++) {
+		const osmscout::Timestamp time(std::chrono::duration_cast<osmscout::Timestamp::duration>(std::chrono::milliseconds(times[i])));
+		steps.emplace_back(time, speeds[i] / SpeedScale, osmscout::GeoCoord(lats[i] / CoordScale, lons[i] / CoordScale),
+			hdops[i] / HdopScale, satellites[i], fixTypes[i]);
+	}
+
+	info.firstPosValid = (header.flags & FlagFirstPos) != 0;
+	info.firstPos = osmscout::GeoCoord(header.firstLat, header.firstLon);
+	info.farthestPosValid = (header.flags & FlagFarthestPos) != 0;
+	info.farthestPos = osmscout::GeoCoord(header.farthestLat, header.farthestLon);
+	return true;
+}
+
+template <typename T>
+static void WriteColumn(std::ofstream& stream, const std::vector<T>& column) {
+	stream.write(reinterpret_cast<const char*>(column.data()), column.size() * sizeof(T));
+}
+
+bool TrackCache::Save(const std::string& sourceFilename, const IPathGenerator::StepTrack& steps, const TrackCacheInfo& info) {
+	TrackCacheHeader header{};
+	if (!GetSourceInfo(sourceFilename, header.sourceSize, header.sourceModified)) return false;
+
+	std::memcpy(header.magic, Magic, sizeof(Magic));
+	header.version = Version;
+	header.byteOrder = ByteOrderMark;
+	header.flags = (info.firstPosValid ? FlagFirstPos : 0) | (info.farthestPosValid ? FlagFarthestPos : 0);
+	header.count = steps.size();
+	header.firstLat = info.firstPos.GetLat();
+	header.firstLon = info.firstPos.GetLon();
+	header.farthestLat = info.farthestPos.GetLat();
+	header.farthestLon = info.farthestPos.GetLon();
+
+	const auto count = steps.size();
+	std::vector<int64_t> times(count);
+	std::vector<int32_t> lats(count);
+	std::vector<int32_t> lons(count);
+	std::vector<uint16_t> speeds(count);
+	std::vector<uint16_t> hdops(count);
+	for (size_t i = 0; i < count; i++) {
+		times[i] = std::chrono::duration_cast<std::chrono::milliseconds>(steps.time(i).time_since_epoch()).count();
+		lats[i] = static_cast<int32_t>(std::lround(steps.lats()[i] * CoordScale));
+		lons[i] = static_cast<int32_t>(std::lround(steps.lons()[i] * CoordScale));
+		const auto speed = std::lround(steps.speed(i) * SpeedScale);
+		speeds[i] = static_cast<uint16_t>(speed < 0 ? 0 : (speed > UINT16_MAX ? UINT16_MAX : speed));
+		const auto hdop = std::lround(steps.hdop(i) * HdopScale);
+		hdops[i] = static_cast<uint16_t>(hdop < 0 ? 0 : (hdop > UINT16_MAX ? UINT16_MAX : hdop));
+	}
+
+	//Write beside and rename, a broken run leaves no half cache
+	const auto cacheFilename = GetCacheFilename(sourceFilename);
+	const auto tempFilename = cacheFilename + ".tmp";
+	{
+		std::ofstream stream(tempFilename, std::ofstream::binary | std::ofstream::trunc);
+		if (!stream.is_open()) {
+			LOG(WARNING) << "Can't write track cache " << tempFilename;
+			return false;
+		}
+		stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		WriteColumn(stream, times);
+		WriteColumn(stream, lats);
+		WriteColumn(stream, lons);
+		WriteColumn(stream, speeds);
+		WriteColumn(stream, hdops);
+		WriteColumn(stream, steps.satellites());
+		WriteColumn(stream, steps.fixTypes());
+		if (!stream.good()) {
+			stream.close();
+			std::remove(tempFilename.c_str());
+			return false;
+		}
+	}
+
+	std::remove(cacheFilename.c_str());
+	if (std::rename(tempFilename.c_str(), cacheFilename.c_str()) != 0) {
+		std::remove(tempFilename.c_str());
+		return false;
+	}
+	return true;
+}
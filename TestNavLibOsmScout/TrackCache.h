@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "IPathGenerator.h"
+
+/**
+ * What the decode of a NMEA log found beside the steps
+ */
+struct TrackCacheInfo
+{
+	osmscout::GeoCoord firstPos;
+	osmscout::GeoCoord farthestPos;
+	bool               firstPosValid;
+	bool               farthestPosValid;
+
+	TrackCacheInfo()
+		: firstPosValid(false),
+		farthestPosValid(false)
+	{
+		// no code
+	}
+};
+
+/**
+ * Binary cache of the decoded steps of a NMEA log, stored beside the log.
+ * Time in ms, lat/lon in 1e-7 degree, speed in 0.01 km/h, HDOP in 0.01, satellites and fix type,
+ * one column after the other.
+ * The cache is only used while size and modification time (in ns) of the log are the same.
+ */
+class TrackCache
+{
+public:
+	static const uint32_t Version = 3;
+
+	static std::string GetCacheFilename(const std::string& sourceFilename);
+	static bool Load(const std::string& sourceFilename, IPathGenerator::StepTrack& steps, TrackCacheInfo& info);
+	static bool Save(const std::string& sourceFilename, const IPathGenerator::StepTrack& steps, const TrackCacheInfo& info);
+};
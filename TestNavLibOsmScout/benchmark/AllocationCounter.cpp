@@ -0,0 +1,41 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "AllocationCounter.h"
+
+static std::atomic<size_t> allocationCount(0);
+
+static void* Allocate(size_t size) {
+	allocationCount++;
+	if (auto memory = std::malloc(size > 0 ? size : 1)) return memory;
+	throw std::bad_alloc();
+}
+
+size_t AllocationCounter::Get() {
+	return allocationCount.load();
+}
+
+void* operator new(size_t size) {
+	return Allocate(size);
+}
+
+void* operator new[](size_t size) {
+	return Allocate(size);
+}
+
+void operator delete(void* memory) noexcept {
+	std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+	std::free(memory);
+}
+
+//Called instead of the unsized ones with -fsized-deallocation (default since C++14)
+void operator delete(void* memory, size_t) noexcept {
+	std::free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept {
+	std::free(memory);
+}
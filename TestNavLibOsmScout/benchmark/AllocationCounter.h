@@ -0,0 +1,13 @@
+#pragma once
+#include <cstddef>
+
+/**
+ * Counts the calls of the global operator new and new[], which are replaced in
+ * AllocationCounter.cpp. They are in a translation unit of their own, so the
+ * compiler can't inline them into the callers and mix up malloc and new.
+ */
+class AllocationCounter
+{
+public:
+	static size_t Get();
+};
@@ -0,0 +1,168 @@
+#include <iomanip>
+#include <sstream>
+#include "LegacyNMEADecoder.h"
+#include "../Tokenizer.h"
+
+//Copy of NMEADecoder.cpp before the decode went to NMEAField, so the benchmark compares with
+//the old decode and not only with its tokenizer. Without the logging and without the reads
+//behind the last field of short RMC sentences, the rest is unchanged
+
+#define KMPH    1.852       // kilometers-per-hour in one knot
+
+LegacyNMEADecoder::LegacyNMEADecoder():
+	_geoLat(0),
+	_geoLon(0),
+	_speed(0),
+	_compass(-1),
+	_posValid(false),
+	_timestampValid(false),
+	_speedValid(false),
+	_compassValid(false),
+	_lastTimestamp(0),
+	_lastTime(),
+	_satelliteOnline(false) {
+}
+
+void LegacyNMEADecoder::DecodeGPGGA() {
+	DecodeUtcTime(_data[1]);
+	if (std::stoi(_data[6]) > 0) {
+		DecodeLat(_data[3], _data[2]);
+		DecodeLon(_data[5], _data[4]);
+		_posValid = true;
+		_satelliteOnline = true;
+	} else {
+		_satelliteOnline = false;
+	}
+}
+
+void LegacyNMEADecoder::DecodeGPGLL() {
+	if (_data[6] == "A") {
+		DecodeLat(_data[2], _data[1]);
+		DecodeLon(_data[4], _data[3]);
+		DecodeUtcTime(_data[5]);
+		_posValid = true;
+		_satelliteOnline = true;
+	} else {
+		_satelliteOnline = false;
+	}
+}
+
+void LegacyNMEADecoder::DecodeUtcTime(const std::string& time) {
+	static const std::string dateTimeFormat{ "%H:%M:%S" };
+	auto timeLocal = time;
+	const auto j = timeLocal.find_first_of('.');
+	if (std::string::npos != j)
+	{
+		timeLocal = timeLocal.substr(0, j);
+	}
+	timeLocal = timeLocal.substr(0, 2) + ":" + timeLocal.substr(2);
+	timeLocal = timeLocal.substr(0, 5) + ":" + timeLocal.substr(5);
+	std::istringstream input(timeLocal);
+	input.imbue(std::locale(setlocale(LC_ALL, nullptr)));
+	input >> std::get_time(&_lastTime, dateTimeFormat.c_str());
+}
+
+void LegacyNMEADecoder::DecodeLat(const std::string& richtung, const std::string& value) {
+	_geoLat = std::stoi(value.substr(0, 2));
+	double nMinuten = std::stof(value.substr(2));
+	nMinuten = nMinuten / 60;
+	_geoLat += nMinuten;
+	if (richtung == "S") {
+		_geoLat = -_geoLat;
+	}
+}
+
+void LegacyNMEADecoder::DecodeLon(const std::string& richtung, const std::string& value) {
+	_geoLon = std::stoi(value.substr(0, 3));
+	double nMinuten = std::stof(value.substr(3));
+	nMinuten = nMinuten / 60;
+	_geoLon += nMinuten;
+	if (richtung == "W") {
+		_geoLon = -_geoLon;
+	}
+}
+
+void LegacyNMEADecoder::DecodeDate(const std::string& dateString) {
+	static const std::string dateTimeFormat{ "%d.%m.%Y" };
+	auto dateLocal = dateString;
+	dateLocal = dateLocal.substr(0, 2) + "." + dateLocal.substr(2);
+	dateLocal = dateLocal.substr(0, 5) + ".20" + dateLocal.substr(5);
+
+	std::tm dt{};
+	std::istringstream input(dateLocal);
+	input.imbue(std::locale(setlocale(LC_ALL, nullptr)));
+	input >> std::get_time(&dt, dateTimeFormat.c_str());
+	if (input.fail()) {
+		return;
+	}
+
+	dt.tm_hour = _lastTime.tm_hour;
+	dt.tm_sec = _lastTime.tm_sec;
+	dt.tm_min = _lastTime.tm_min;
+
+	_lastTimestamp = std::mktime(&dt);
+	_timestampValid = true;
+}
+
+void LegacyNMEADecoder::DecodeGPRMC() {
+	DecodeUtcTime(_data[1]);
+	if (_data[2] == "A") {
+		DecodeLat(_data[4], _data[3]);
+		DecodeLon(_data[6], _data[5]);
+		_posValid = true;
+		if (_data.size() > 8) {
+			if (_data[7].length() > 0) {
+				_speedValid = true;
+				_speed = std::stof(_data[7]) * KMPH;
+			}
+			if (_data[8].length() > 0) {
+				_compassValid = true;
+				_compass = std::stof(_data[8]);
+			}
+			if (_data.size() > 9) {
+				if (!_data[9].empty()) {
+					DecodeDate(_data[9]);
+				}
+			}
+		}
+		_satelliteOnline = true;
+	} else {
+		_satelliteOnline = false;
+	}
+}
+
+bool LegacyNMEADecoder::Decode(const std::string& line) {
+	_timestampValid = false;
+	_data.clear();
+	Tokenizer tokenizer(line, ",*");
+
+	while (tokenizer.NextToken()) {
+		_data.push_back(tokenizer.GetToken());
+	}
+
+	if (_data.empty()) return false;
+
+	if (_data[0] == "$GPGGA") {
+		DecodeGPGGA();
+	} else if (_data[0] == "$GPGSA" || _data[0] == "$GPGSV") {
+		//Nothing decoded
+	} else if (_data[0] == "$GPRMC") {
+		DecodeGPRMC();
+	} else if (_data[0] == "$GPGLL") {
+		DecodeGPGLL();
+	} else {
+		return false;
+	}
+
+	if (!_satelliteOnline) {
+		_posValid = false;
+		_timestampValid = false;
+		_speedValid = false;
+	}
+
+	return true;
+}
+
+bool LegacyNMEADecoder::IsPositionValid() const {
+	return _posValid;
+}
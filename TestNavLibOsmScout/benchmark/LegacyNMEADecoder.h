@@ -0,0 +1,39 @@
+#pragma once
+
+#include <ctime>
+#include <string>
+#include <vector>
+
+/**
+ * The decoder as it was before NMEAField: Tokenizer, a std::string per field, stoi/stof
+ * and istringstream with get_time. Only kept as the "before" of NMEADecoderBenchmark.
+ */
+class LegacyNMEADecoder
+{
+	std::vector<std::string> _data;
+	double _geoLat;
+	double _geoLon;
+	double _speed;
+	double _compass;
+	bool _posValid;
+	bool _timestampValid;
+	bool _speedValid;
+	bool _compassValid;
+	std::time_t _lastTimestamp;
+	std::tm     _lastTime;
+	bool _satelliteOnline;
+
+	void DecodeGPGGA();
+	void DecodeGPGLL();
+	void DecodeGPRMC();
+	void DecodeUtcTime(const std::string& time);
+	void DecodeLat(const std::string& richtung, const std::string& value);
+	void DecodeLon(const std::string& richtung, const std::string& value);
+	void DecodeDate(const std::string& dateString);
+
+public:
+	LegacyNMEADecoder();
+
+	bool Decode(const std::string& line);
+	bool IsPositionValid() const;
+};
@@ -0,0 +1,409 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../utils/easylogging++.h"
+#include "../NMEADecoder.h"
+#include "../NMEAFixBatch.h"
+#include "../NMEALogFile.h"
+#include "../Tokenizer.h"
+#include "AllocationCounter.h"
+#include "LegacyNMEADecoder.h"
+
+//Benchmark suite for the NMEA decode path
+//Call NMEADecoderBenchmark [--count n] [--file recorded.nmea]... [--save-baseline file]
+//                          [--baseline file [--max-drop percent]]
+//With --baseline the exit code is 1 if a measurement is more than max-drop percent slower, in every one of three runs
+//--save-baseline stores the median of three runs
+//The baseline stores the throughput relative to Tokenizer split of the same corpus, not sentences/s,
+//so it holds on faster and slower machines too
+
+struct Corpus
+{
+	std::string name;
+	std::string buffer;
+	std::vector<std::pair<size_t, size_t>> lines; //offset and length in buffer
+
+	void Add(const char* line, size_t length)
+	{
+		lines.emplace_back(buffer.size(), length);
+		buffer.append(line, length);
+		buffer += "\r\n";
+	}
+
+	const char* Line(size_t index) const
+	{
+		return buffer.data() + lines[index].first;
+	}
+};
+
+struct Result
+{
+	std::string name;
+	double      sentencesPerSecond;
+	double      bytesPerSecond;
+	double      allocationsPerSentence;
+	double      relative; //sentences/s against the reference of the corpus
+};
+
+//Reference of every corpus, the string based split does not change with the decoder
+static const char* const ReferenceMeasurement = "Tokenizer split";
+static const char* const BaselineHeader = "# NMEADecoderBenchmark baseline, <sentences/s relative to Tokenizer split> <corpus>/<measurement>";
+
+static std::string WithChecksum(const char* body) {
+	unsigned char crc = 0;
+	for (auto c = body; *c != '\0'; c++) {
+		crc ^= static_cast<unsigned char>(*c);
+	}
+	char tail[8];
+	std::snprintf(tail, sizeof(tail), "*%02X", crc);
+	return std::string("$") + body + tail;
+}
+
+enum SentenceMask
+{
+	RMC = 1,
+	GGA = 2,
+	GLL = 4
+};
+
+static Corpus CreateCorpus(const std::string& name, unsigned mask, size_t count) {
+	Corpus corpus;
+	corpus.name = name;
+	corpus.lines.reserve(count);
+	char body[128];
+	for (size_t i = 0; corpus.lines.size() < count; i++) {
+		const auto second = static_cast<unsigned>(i % 60);
+		const auto minute = static_cast<unsigned>((i / 60) % 60);
+		const auto lat = 24.6102 + (i % 1000) * 0.0001;
+		const auto lon = 21.8833 + (i % 1000) * 0.0001;
+		if ((mask & RMC) != 0 && corpus.lines.size() < count) {
+			std::snprintf(body, sizeof(body), "GPRMC,18%02u%02u.000,A,50%07.4f,N,009%07.4f,E,%.2f,61.16,010519,,,A",
+				minute, second, lat, lon, 20.0 + (i % 50));
+			const auto line = WithChecksum(body);
+			corpus.Add(line.data(), line.size());
+		}
+		if ((mask & GGA) != 0 && corpus.lines.size() < count) {
+			std::snprintf(body, sizeof(body), "GPGGA,18%02u%02u.000,50%07.4f,N,009%07.4f,E,1,08,1.1,351.5,M,48.0,M,,",
+				minute, second, lat, lon);
+			const auto line = WithChecksum(body);
+			corpus.Add(line.data(), line.size());
+		}
+		if ((mask & GLL) != 0 && corpus.lines.size() < count) {
+			std::snprintf(body, sizeof(body), "GPGLL,50%07.4f,N,009%07.4f,E,18%02u%02u.000,A,A",
+				lat, lon, minute, second);
+			const auto line = WithChecksum(body);
+			corpus.Add(line.data(), line.size());
+		}
+	}
+	return corpus;
+}
+
+static bool LoadCorpus(const std::string& filename, Corpus& corpus) {
+	NMEALogFile log;
+	if (!log.Open(filename)) return false;
+
+	//Without the directory, the baseline stays valid on other machines
+	corpus.name = "recorded " + filename.substr(filename.find_last_of("/\\") + 1);
+	corpus.buffer.reserve(log.Size() + log.Size() / 16);
+	auto reader = log.CreateReader();
+	const char* line;
+	size_t length;
+	while (reader.Next(line, length)) {
+		if (length > 0) corpus.Add(line, length);
+	}
+	return !corpus.lines.empty();
+}
+
+//Best of some passes, a single pass is too noisy for the regression check
+static const int Passes = 5;
+//Runs of all corpora before a drop against the baseline counts
+static const size_t CheckRuns = 3;
+
+template <typename Function>
+static Result Measure(const Corpus& corpus, const char* name, Function function) {
+	size_t bytes = 0;
+	for (const auto& line : corpus.lines) {
+		bytes += line.second;
+	}
+
+	auto best = 0.0;
+	size_t allocations = 0;
+	size_t accepted = 0;
+	for (int pass = 0; pass < Passes; pass++) {
+		accepted = 0;
+		const auto allocationsBefore = AllocationCounter::Get();
+		const auto begin = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < corpus.lines.size(); i++) {
+			if (function(corpus.Line(i), corpus.lines[i].second)) accepted++;
+		}
+		const auto end = std::chrono::steady_clock::now();
+		allocations = AllocationCounter::Get() - allocationsBefore;
+
+		const auto seconds = std::chrono::duration<double>(end - begin).count();
+		if (pass == 0 || seconds < best) best = seconds;
+	}
+
+	Result result;
+	result.name = corpus.name + "/" + name;
+	result.sentencesPerSecond = corpus.lines.size() / best;
+	result.relative = 0.0;
+	result.bytesPerSecond = bytes / best;
+	result.allocationsPerSentence = static_cast<double>(allocations) / corpus.lines.size();
+
+	std::printf("%-55s %10.0f sentences/s %8.1f MB/s %6.2f allocs/sentence (%zu accepted)\n",
+		result.name.c_str(), result.sentencesPerSecond, result.bytesPerSecond / (1024 * 1024),
+		result.allocationsPerSentence, accepted);
+	return result;
+}
+
+//Same for functions that take the whole buffer at once
+template <typename Function>
+static Result MeasureBuffer(const Corpus& corpus, const char* name, Function function) {
+	const auto allocationsBefore = AllocationCounter::Get();
+	size_t accepted = 0;
+	auto best = 0.0;
+	for (int pass = 0; pass < Passes; pass++) {
+		const auto begin = std::chrono::steady_clock::now();
+		accepted = function(corpus.buffer.data(), corpus.buffer.data() + corpus.buffer.size());
+		const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+		if (pass == 0 || seconds < best) best = seconds;
+	}
+
+	Result result;
+	result.name = corpus.name + "/" + name;
+	result.sentencesPerSecond = corpus.lines.size() / best;
+	result.relative = 0.0;
+	result.bytesPerSecond = corpus.buffer.size() / best;
+	result.allocationsPerSentence = static_cast<double>(AllocationCounter::Get() - allocationsBefore) / Passes / corpus.lines.size();
+
+	std::printf("%-55s %10.0f sentences/s %8.1f MB/s %6.2f allocs/sentence (%zu accepted)\n",
+		result.name.c_str(), result.sentencesPerSecond, result.bytesPerSecond / (1024 * 1024),
+		result.allocationsPerSentence, accepted);
+	return result;
+}
+
+//Results from first on belong to one corpus
+static void SetRelative(const Corpus& corpus, std::vector<Result>& results, size_t first) {
+	const auto referenceName = corpus.name + "/" + ReferenceMeasurement;
+	auto reference = 0.0;
+	for (size_t i = first; i < results.size(); i++) {
+		if (results[i].name == referenceName) reference = results[i].sentencesPerSecond;
+	}
+	for (size_t i = first; i < results.size(); i++) {
+		results[i].relative = reference > 0 ? results[i].sentencesPerSecond / reference : 0.0;
+	}
+}
+
+static void RunCorpus(const Corpus& corpus, std::vector<Result>& results) {
+	const auto first = results.size();
+
+	//The old decode with Tokenizer, stoi/stof and istringstream, the before of NMEADecoder::Decode
+	LegacyNMEADecoder legacyDecoder;
+	results.push_back(Measure(corpus, "LegacyNMEADecoder::Decode", [&legacyDecoder](const char* line, size_t length) {
+		//It throws on broken fields, recorded logs have some
+		try {
+			return legacyDecoder.Decode(std::string(line, length)) && legacyDecoder.IsPositionValid();
+		} catch (const std::exception&) {
+			return false;
+		}
+	}));
+
+	//Only the tokenize part of the old decode
+	std::vector<std::string> data;
+	results.push_back(Measure(corpus, ReferenceMeasurement, [&data](const char* line, size_t length) {
+		data.clear();
+		Tokenizer tokenizer(std::string(line, length), ",*");
+		while (tokenizer.NextToken()) {
+			data.push_back(tokenizer.GetToken());
+		}
+		return !data.empty();
+	}));
+
+	NMEAField fields[32];
+	results.push_back(Measure(corpus, "NMEAField split", [&fields](const char* line, size_t length) {
+		return NMEAField::Split(line, length, fields, 32) > 0;
+	}));
+
+	NMEAChecksumStats checksumStats;
+	results.push_back(Measure(corpus, "NMEAChecksum::Verify", [&checksumStats](const char* line, size_t length) {
+		return NMEAChecksum::Verify(line, length, checksumStats);
+	}));
+
+	NMEADecoder decoder;
+	results.push_back(Measure(corpus, "NMEADecoder::Decode", [&decoder](const char* line, size_t length) {
+		return decoder.Decode(line, length) && decoder.IsPositionValid();
+	}));
+
+	results.push_back(MeasureBuffer(corpus, "NMEAChecksum::VerifyBuffer", [&checksumStats](const char* begin, const char* end) {
+		return NMEAChecksum::VerifyBuffer(begin, end - begin, checksumStats);
+	}));
+
+	NMEADecoder batchDecoder;
+	NMEAFixBatch batch;
+	results.push_back(MeasureBuffer(corpus, "NMEADecoder::DecodeBatch", [&batchDecoder, &batch](const char* begin, const char* end) {
+		size_t fixes = 0;
+		while (begin < end) {
+			begin = batchDecoder.DecodeBatch(begin, end, batch);
+			fixes += batch.Size();
+		}
+		return fixes;
+	}));
+
+	SetRelative(corpus, results, first);
+}
+
+static std::vector<Result> RunCorpora(const std::vector<Corpus>& corpora) {
+	std::vector<Result> results;
+	for (const auto& corpus : corpora) {
+		std::cout << "Decode " << corpus.lines.size() << " sentences of " << corpus.name << std::endl;
+		RunCorpus(corpus, results);
+	}
+	return results;
+}
+
+static bool LoadBaseline(const std::string& filename, std::map<std::string, double>& baseline) {
+	std::ifstream stream(filename);
+	if (!stream.is_open()) return false;
+
+	//Baselines with absolute sentences/s from older versions can't be compared
+	std::string line;
+	if (!std::getline(stream, line) || line != BaselineHeader) return false;
+
+	//<relative> <name>, lines with # are comments
+	while (std::getline(stream, line)) {
+		if (line.empty() || line[0] == '#') continue;
+		const auto separator = line.find(' ');
+		if (separator == std::string::npos) continue;
+		baseline[line.substr(separator + 1)] = std::atof(line.substr(0, separator).c_str());
+	}
+	return true;
+}
+
+static bool SaveBaseline(const std::string& filename, const std::vector<Result>& results) {
+	std::ofstream stream(filename, std::ofstream::trunc);
+	if (!stream.is_open()) return false;
+
+	stream << BaselineHeader << std::endl;
+	for (const auto& result : results) {
+		stream << std::fixed << std::setprecision(4) << result.relative << " " << result.name << std::endl;
+	}
+	return stream.good();
+}
+
+static size_t CheckBaseline(const std::map<std::string, double>& baseline, const std::vector<Result>& results, double maxDrop, bool report) {
+	size_t regressions = 0;
+	for (const auto& result : results) {
+		const auto entry = baseline.find(result.name);
+		if (entry == baseline.end() || entry->second <= 0 || result.relative <= 0) continue;
+
+		const auto change = (result.relative / entry->second - 1.0) * 100.0;
+		if (change < -maxDrop) {
+			if (report) std::printf("REGRESSION %-44s %+6.1f %% (%.3f, baseline %.3f x %s)\n", result.name.c_str(), change,
+				result.relative, entry->second, ReferenceMeasurement);
+			regressions++;
+		}
+	}
+	return regressions;
+}
+
+INITIALIZE_EASYLOGGINGPP
+int main(int argc, char *argv[])
+{
+	size_t count = 200000;
+	std::vector<std::string> files;
+	std::string baselineFile;
+	std::string saveBaselineFile;
+	//Same as NMEA_BENCHMARK_MAX_DROP in CMakeLists.txt
+	auto maxDrop = 20.0;
+
+	for (int i = 1; i < argc; i++) {
+		const std::string argument = argv[i];
+		if (argument == "--count" && i + 1 < argc) {
+			count = std::strtoul(argv[++i], nullptr, 10);
+		} else if (argument == "--file" && i + 1 < argc) {
+			files.push_back(argv[++i]);
+		} else if (argument == "--baseline" && i + 1 < argc) {
+			baselineFile = argv[++i];
+		} else if (argument == "--save-baseline" && i + 1 < argc) {
+			saveBaselineFile = argv[++i];
+		} else if (argument == "--max-drop" && i + 1 < argc) {
+			maxDrop = std::atof(argv[++i]);
+		} else {
+			std::cerr << "NMEADecoderBenchmark [--count n] [--file recorded.nmea]... [--save-baseline file] [--baseline file [--max-drop percent]]" << std::endl;
+			return 2;
+		}
+	}
+
+	std::vector<Corpus> corpora;
+	corpora.push_back(CreateCorpus("synthetic RMC", RMC, count));
+	corpora.push_back(CreateCorpus("synthetic GGA", GGA, count));
+	corpora.push_back(CreateCorpus("synthetic GLL", GLL, count));
+	corpora.push_back(CreateCorpus("synthetic RMC/GGA/GLL", RMC | GGA | GLL, count));
+	for (const auto& file : files) {
+		Corpus corpus;
+		if (!LoadCorpus(file, corpus)) {
+			std::cerr << "Can't read NMEA log " << file << std::endl;
+			return 2;
+		}
+		corpora.push_back(std::move(corpus));
+	}
+
+	auto results = RunCorpora(corpora);
+
+	if (!saveBaselineFile.empty()) {
+		//The median of the runs, a lucky run would make the later checks fail
+		std::vector<std::vector<Result>> runs(1, results);
+		while (runs.size() < CheckRuns) {
+			runs.push_back(RunCorpora(corpora));
+		}
+		auto median = results;
+		for (size_t i = 0; i < median.size(); i++) {
+			std::vector<double> relative;
+			for (const auto& run : runs) {
+				relative.push_back(run[i].relative);
+			}
+			std::sort(relative.begin(), relative.end());
+			median[i].relative = relative[relative.size() / 2];
+		}
+		if (!SaveBaseline(saveBaselineFile, median)) {
+			std::cerr << "Can't write baseline " << saveBaselineFile << std::endl;
+			return 2;
+		}
+		std::cout << "Baseline written to " << saveBaselineFile << std::endl;
+	}
+
+	if (!baselineFile.empty()) {
+		std::map<std::string, double> baseline;
+		if (!LoadBaseline(baselineFile, baseline)) {
+			std::cerr << "Can't read baseline " << baselineFile << std::endl;
+			return 2;
+		}
+		//A busy machine slows single measurements down, a regression has to show in every run
+		auto regressions = CheckBaseline(baseline, results, maxDrop, false);
+		for (size_t run = 1; regressions > 0 && run < CheckRuns; run++) {
+			std::cout << regressions << " measurements below the baseline, measure again" << std::endl;
+			const auto again = RunCorpora(corpora);
+			for (size_t i = 0; i < results.size(); i++) {
+				if (again[i].relative > results[i].relative) results[i] = again[i];
+			}
+			regressions = CheckBaseline(baseline, results, maxDrop, false);
+		}
+		CheckBaseline(baseline, results, maxDrop, true);
+		if (regressions > 0) {
+			std::cout << regressions << " measurements more than " << maxDrop << " % below the baseline" << std::endl;
+			return 1;
+		}
+		std::cout << "No measurement more than " << maxDrop << " % below the baseline" << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,120 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "../utils/easylogging++.h"
+#include "../NMEAChecksum.h"
+#include "../NMEADecoder.h"
+#include "../NMEAField.h"
+#include "../NMEAFixBatch.h"
+
+//Fuzz target for the NMEA decode path
+//libFuzzer: build with NMEA_FUZZ_LIBFUZZER=ON and call NMEADecoderFuzzer fuzz/corpus
+//AFL and replay: NMEADecoderFuzzer file... (or the input on stdin)
+//Every input is decoded line by line with a fresh decoder, so the state between sentences is fuzzed too
+
+static void Check(bool condition, const char* what) {
+	if (!condition) {
+		std::fprintf(stderr, "Invariant broken: %s\n", what);
+		std::abort();
+	}
+}
+
+static void CheckFix(const NMEADecoder& decoder) {
+	if (decoder.IsPositionValid()) {
+		Check(decoder.GetLatitude() >= -90.0 && decoder.GetLatitude() <= 90.0, "latitude in range");
+		Check(decoder.GetLongitude() >= -180.0 && decoder.GetLongitude() <= 180.0, "longitude in range");
+	}
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+	static const auto loggingOff = []() {
+		//Thousands of broken sentences per second would only fill the log
+		el::Configurations configurations;
+		configurations.setToDefault();
+		configurations.set(el::Level::Global, el::ConfigurationType::Enabled, "false");
+		el::Loggers::setDefaultConfigurations(configurations, true);
+		return true;
+	}();
+	(void)loggingOff;
+
+	//Own copy, so reading one byte behind the input is found by the sanitizer
+	const std::vector<char> input(data, data + size);
+	const auto begin = input.data();
+	const auto end = begin + input.size();
+
+	NMEAChecksumStats stats;
+	Check(NMEAChecksum::VerifyBuffer(begin, input.size(), stats) <= stats.checked, "valid sentences counted");
+
+	NMEAField fields[32];
+	const auto fieldCount = NMEAField::Split(begin, input.size(), fields, 32);
+	for (size_t i = 0; i < fieldCount; i++) {
+		double value;
+		uint32_t number;
+		int32_t degrees;
+		fields[i].ToDouble(value);
+		fields[i].ToUnsigned(number);
+		if (fields[i].ToDegreesE7(2, degrees)) Check(degrees >= 0 && degrees <= 1800000000, "degrees in range");
+		fields[i].ToDegreesE7(3, degrees);
+	}
+
+	//Line by line and batched must see the same fixes
+	NMEADecoder lineDecoder;
+	size_t lineFixes = 0;
+	auto line = begin;
+	while (line < end) {
+		auto lineEnd = line;
+		while (lineEnd < end && *lineEnd != '\n') lineEnd++;
+		if (lineDecoder.Decode(line, lineEnd - line) && lineDecoder.IsPositionDecoded()) {
+			lineFixes++;
+		}
+		CheckFix(lineDecoder);
+		line = lineEnd < end ? lineEnd + 1 : end;
+	}
+
+	NMEADecoder batchDecoder;
+	NMEAFixBatch batch(4);
+	size_t batchFixes = 0;
+	auto position = begin;
+	while (position < end) {
+		const auto next = batchDecoder.DecodeBatch(position, end, batch);
+		Check(next > position && next <= end, "batch makes progress");
+		Check(batch.Size() <= batch.Capacity(), "batch in capacity");
+		batchFixes += batch.Size();
+		position = next;
+	}
+	Check(lineFixes == batchFixes, "batch and line decode agree");
+
+	return 0;
+}
+
+INITIALIZE_EASYLOGGINGPP
+
+#ifdef NMEA_FUZZ_STANDALONE
+
+static int Run(std::istream& stream) {
+	const std::string input((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+	return LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t*>(input.data()), input.size());
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2) {
+		return Run(std::cin);
+	}
+	for (int i = 1; i < argc; i++) {
+		std::ifstream stream(argv[i], std::ifstream::binary);
+		if (!stream.is_open()) {
+			std::cerr << "Can't read " << argv[i] << std::endl;
+			return 2;
+		}
+		Run(stream);
+	}
+	std::cout << argc - 1 << " inputs decoded" << std::endl;
+	return 0;
+}
+#endif
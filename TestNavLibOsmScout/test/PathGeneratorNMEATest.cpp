@@ -0,0 +1,122 @@
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "../utils/easylogging++.h"
+#include "../NMEALogFile.h"
+#include "../PathGeneratorNMEA.h"
+
+//GenerateStepsParallel must give the same steps as GenerateSteps, column by column.
+//The logs are big enough for four chunks.
+
+static const char* LogFilename = "PathGeneratorNMEATest.nmea";
+//Not a multiple of four and lines of different length, the chunks don't start with an epoch
+static const size_t Epochs = 80003;
+
+enum LogContent
+{
+	AllSentences,   // RMC, GGA, GSA, GSV every epoch
+	LateGsa,        // GSA only in the second half of the log
+	RmcOnly
+};
+
+static std::string WithChecksum(const char* body) {
+	unsigned char crc = 0;
+	for (auto c = body; *c != '\0'; c++) {
+		crc ^= static_cast<unsigned char>(*c);
+	}
+	char tail[8];
+	std::snprintf(tail, sizeof(tail), "*%02X\r\n", crc);
+	return std::string("$") + body + tail;
+}
+
+static bool WriteLog(LogContent content) {
+	std::ofstream stream(LogFilename, std::ofstream::binary | std::ofstream::trunc);
+	char body[128];
+	for (size_t i = 0; i < Epochs; i++) {
+		const auto hour = static_cast<unsigned>(i / 3600);
+		const auto minute = static_cast<unsigned>((i / 60) % 60);
+		const auto second = static_cast<unsigned>(i % 60);
+		const auto lat = 24.6102 + (i % 5000) * 0.0001;
+		const auto lon = 21.8833 + (i % 3000) * 0.0001;
+		std::snprintf(body, sizeof(body), "GPRMC,%02u%02u%02u.000,A,50%07.4f,N,009%07.4f,E,%.2f,61.16,010519,,,A",
+			hour, minute, second, lat, lon, 5.0 + (i % 97));
+		stream << WithChecksum(body);
+		if (content == RmcOnly) continue;
+		std::snprintf(body, sizeof(body), "GPGGA,%02u%02u%02u.000,50%07.4f,N,009%07.4f,E,1,%02u,%.1f,351.5,M,48.0,M,,",
+			hour, minute, second, lat, lon, static_cast<unsigned>(4 + i % 9), 0.8 + (i % 7) * 0.3);
+		stream << WithChecksum(body);
+		if (content == AllSentences || i >= Epochs / 2) {
+			std::snprintf(body, sizeof(body), "GPGSA,A,%u,04,05,,09,12,,,24,,,,,2.5,%.1f,2.1",
+				static_cast<unsigned>(2 + i % 2), 0.9 + (i % 5) * 0.4);
+			stream << WithChecksum(body);
+		}
+		stream << WithChecksum("GPGSV,3,1,11,03,03,111,00,04,15,270,00,06,01,010,00,13,06,292,00");
+	}
+	return stream.good();
+}
+
+static size_t Compare(const char* name, const IPathGenerator::StepTrack& expected, const IPathGenerator::StepTrack& actual) {
+	if (expected.size() != actual.size()) {
+		std::cout << name << ": " << actual.size() << " steps instead of " << expected.size() << std::endl;
+		return 1;
+	}
+
+	size_t failures = 0;
+	const auto column = [&failures, name](const char* columnName, size_t index, bool equal) {
+		if (!equal && failures++ < 10) {
+			std::cout << name << ": step " << index << " differs in " << columnName << std::endl;
+		}
+	};
+	for (size_t i = 0; i < expected.size(); i++) {
+		column("time", i, expected.time(i) == actual.time(i));
+		column("lat", i, expected.lats()[i] == actual.lats()[i]);
+		column("lon", i, expected.lons()[i] == actual.lons()[i]);
+		column("speed", i, expected.speed(i) == actual.speed(i));
+		column("hdop", i, expected.hdop(i) == actual.hdop(i));
+		column("satellites", i, expected.satellites()[i] == actual.satellites()[i]);
+		column("fix type", i, expected.fixTypes()[i] == actual.fixTypes()[i]);
+	}
+	return failures;
+}
+
+static size_t Run(const char* name, LogContent content) {
+	if (!WriteLog(content)) {
+		std::cout << name << ": can't write " << LogFilename << std::endl;
+		return 1;
+	}
+
+	NMEALogFile log;
+	if (!log.Open(LogFilename)) {
+		std::cout << name << ": can't read " << LogFilename << std::endl;
+		return 1;
+	}
+
+	PathGeneratorNMEA sequential(log, 100.0);
+	PathGeneratorNMEA parallel(log, 100.0);
+	sequential.GenerateSteps();
+	parallel.GenerateStepsParallel(4);
+
+	auto failures = Compare(name, sequential.steps, parallel.steps);
+	double expectedLat, expectedLon, actualLat, actualLon;
+	if (!sequential.GetFarthestPos(expectedLat, expectedLon) || !parallel.GetFarthestPos(actualLat, actualLon) ||
+		expectedLat != actualLat || expectedLon != actualLon) {
+		std::cout << name << ": farthest fix differs" << std::endl;
+		failures++;
+	}
+
+	std::cout << name << ": " << sequential.steps.size() << " steps, " << (failures == 0 ? "same" : "DIFFERENT") << std::endl;
+	return failures;
+}
+
+INITIALIZE_EASYLOGGINGPP
+int main()
+{
+	size_t failures = 0;
+	failures += Run("RMC, GGA, GSA and GSV", AllSentences);
+	failures += Run("GSA in the second half", LateGsa);
+	failures += Run("RMC only", RmcOnly);
+	std::remove(LogFilename);
+	return failures == 0 ? 0 : 1;
+}
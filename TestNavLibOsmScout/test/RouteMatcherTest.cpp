@@ -0,0 +1,157 @@
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include <osmscout/routing/Route.h>
+#include <osmscout/util/Geometry.h>
+#include "../RouteMatcher.h"
+#include "../RouteNavigation.h"
+
+//RouteMatcher and RouteNavigation on a route out and back on the same street, the way back
+//in the other lane. The vehicle drives it in 25 m steps, the fixes are checked against the
+//route position they were taken at.
+
+static const double StartLat = 50.0;
+static const double StartLon = 9.0;
+static const double MeterPerLatDegree = 111195.0;
+static const double LegInMeter = 10000.0;
+static const double NodeSpacingInMeter = 50.0;
+static const double LaneInMeter = 10.0;
+static const double StepInMeter = 25.0;
+//Route positions are measured on the segments, the nodes are hand made
+static const double ToleranceInMeter = 30.0;
+
+static double MeterPerLonDegree() {
+	return MeterPerLatDegree * std::cos(StartLat * M_PI / 180.0);
+}
+
+//The fix driven position meters from the start, the turn between the lanes is not driven
+static osmscout::GeoCoord RoutePosition(double position) {
+	if (position <= LegInMeter) {
+		return osmscout::GeoCoord(StartLat + position / MeterPerLatDegree, StartLon);
+	}
+	const auto back = 2.0 * LegInMeter + LaneInMeter - position;
+	return osmscout::GeoCoord(StartLat + back / MeterPerLatDegree, StartLon + LaneInMeter / MeterPerLonDegree());
+}
+
+static double RouteLength() {
+	return 2.0 * LegInMeter + LaneInMeter;
+}
+
+static void BuildRoute(osmscout::RouteDescription& route) {
+	std::vector<osmscout::GeoCoord> coords;
+	for (double position = 0.0; position <= LegInMeter; position += NodeSpacingInMeter) {
+		coords.push_back(RoutePosition(position));
+	}
+	for (double position = LegInMeter + LaneInMeter; position <= RouteLength(); position += NodeSpacingInMeter) {
+		coords.push_back(RoutePosition(position));
+	}
+
+	double distance = 0.0;
+	for (size_t i = 0; i < coords.size(); i++) {
+		if (i > 0) {
+			distance += osmscout::GetEllipsoidalDistance(coords[i - 1], coords[i]).AsMeter();
+		}
+		route.AddNode(0, i, std::vector<osmscout::ObjectFileRef>(), osmscout::ObjectFileRef(), i + 1);
+		auto& node = route.Nodes().back();
+		node.SetLocation(coords[i]);
+		node.SetDistance(osmscout::Distance::Of<osmscout::Meter>(distance));
+		//50 km/h
+		node.SetTime(distance / 1000.0 / 50.0);
+	}
+}
+
+struct Fix
+{
+	osmscout::GeoCoord coord;
+	double             position;  // m on the route, negative for a fix off the route
+	bool               checked;   // false while the matcher may still be wrong
+};
+
+static void Drive(std::vector<Fix>& fixes, double from, double to, bool checked = true) {
+	for (auto position = from; position <= to; position += StepInMeter) {
+		Fix fix = { RoutePosition(position), position, checked };
+		fixes.push_back(fix);
+	}
+}
+
+static size_t Run(const char* name, const osmscout::RouteDescription& route, const std::vector<Fix>& fixes) {
+	RouteMatcher matcher(route);
+	RouteNavigation navigation;
+	navigation.SetRoute(&route, matcher.GetTable());
+	const auto& table = matcher.GetTable();
+	const auto total = route.Nodes().back().GetDistance().AsMeter();
+
+	size_t failures = 0;
+	const auto fail = [&failures, name](size_t index, const char* what, double expected, double actual) {
+		if (failures++ < 10) {
+			std::cout << name << ": fix " << index << " " << what << " " << actual << " instead of " << expected << std::endl;
+		}
+	};
+	for (size_t i = 0; i < fixes.size(); i++) {
+		const auto& fix = fixes[i];
+		const auto match = matcher.Update(fix.coord);
+		const auto onRoute = navigation.Update(match);
+		if (!fix.checked) continue;
+
+		if (fix.position < 0.0) {
+			if (onRoute) fail(i, "on route at", -1.0, table.Cumulative(match.segment) * 1000.0 + match.offset * 1000.0);
+			continue;
+		}
+		if (!onRoute) {
+			fail(i, "off route by m", 0.0, match.distance);
+			continue;
+		}
+		const auto position = (table.Cumulative(match.segment) + match.offset) * 1000.0;
+		if (std::fabs(position - fix.position) > ToleranceInMeter) {
+			fail(i, "matched at", fix.position, position);
+		}
+		const auto remaining = navigation.GetDistance().AsMeter();
+		if (std::fabs(remaining - (total - fix.position)) > ToleranceInMeter) {
+			fail(i, "remaining", total - fix.position, remaining);
+		}
+	}
+
+	std::cout << name << ": " << fixes.size() << " fixes, " << (failures == 0 ? "ok" : "FAILED") << std::endl;
+	return failures;
+}
+
+int main()
+{
+	osmscout::RouteDescription route;
+	BuildRoute(route);
+	size_t failures = 0;
+
+	//Every fix on the way back is also on the way out, the matcher has to keep to the leg driven
+	std::vector<Fix> outAndBack;
+	Drive(outAndBack, 0.0, RouteLength());
+	failures += Run("Out and back", route, outAndBack);
+
+	//No fixes in a tunnel, the first one behind it is on the way out and not on the way back
+	std::vector<Fix> jumpAhead;
+	Drive(jumpAhead, 0.0, 2000.0);
+	Drive(jumpAhead, 6000.0, RouteLength());
+	failures += Run("Jump ahead", route, jumpAhead);
+
+	//A detour 1 km beside the route, back on it further ahead
+	std::vector<Fix> offRoute;
+	Drive(offRoute, 0.0, 3000.0);
+	for (auto position = 3000.0; position < 4000.0; position += StepInMeter) {
+		Fix fix = { osmscout::GeoCoord(RoutePosition(position).GetLat(), StartLon + 1000.0 / MeterPerLonDegree()), -1.0, true };
+		offRoute.push_back(fix);
+	}
+	Drive(offRoute, 4000.0, RouteLength());
+	failures += Run("Off route", route, offRoute);
+
+	//One fix 5 km ahead, the following ones are on the way back there too. The matcher has to
+	//come back to the way out, it takes some fixes of going backwards on the route.
+	std::vector<Fix> glitch;
+	Drive(glitch, 0.0, 3000.0);
+	Fix ahead = { RoutePosition(8000.0), 8000.0, false };
+	glitch.push_back(ahead);
+	const auto recovered = 3000.0 + StepInMeter * (2 * RouteMatcher::ReseedMisses + 2);
+	Drive(glitch, 3000.0 + StepInMeter, recovered, false);
+	Drive(glitch, recovered + StepInMeter, RouteLength());
+	failures += Run("Glitch ahead", route, glitch);
+
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,87 @@
+#include <iostream>
+#include <string>
+#include "../GpxWriter.h"
+#include "../TelemetryLog.h"
+
+//Converts a telemetry log (routeRouter.navt, routeTour.navt, routeLife.navt) to GPX
+//TelemetryToGpx <in.navt> <out.gpx>
+//GPX wants waypoints, routes and tracks in this order, so the mapped log is read once for each
+
+static std::string EventName(const TelemetryRecord& record, size_t eventCount) {
+	switch (record.type) {
+	case TelemetryRecord::RouteState:
+		return ((record.flags & TelemetryRecord::OnRoute) ? "Route found " : "Route lost ") + std::to_string(eventCount);
+	case TelemetryRecord::StreetChanged:
+		return "Streetname (" + record.text + ")" + std::to_string(eventCount);
+	default:
+		return record.text;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 3) {
+		std::cout << "Please Call TelemetryToGpx <telemetry file> <gpx file>" << std::endl;
+		return 1;
+	}
+
+	TelemetryReader reader;
+	if (!reader.Open(argv[1])) {
+		std::cerr << "Cannot read telemetry file '" << argv[1] << "'!" << std::endl;
+		return 2;
+	}
+
+	GpxWriter writer;
+	if (!writer.Open(argv[2], 1024 * 1024)) {
+		std::cerr << "Cannot open gpx file '" << argv[2] << "'!" << std::endl;
+		return 2;
+	}
+
+	TelemetryRecord record;
+	size_t eventCount = 0;
+	while (reader.Next(record)) {
+		switch (record.type) {
+		case TelemetryRecord::Waypoint:
+		case TelemetryRecord::Instruction:
+			writer.Waypoint(osmscout::GeoCoord(record.lat, record.lon), EventName(record, eventCount));
+			break;
+		case TelemetryRecord::RouteState:
+		case TelemetryRecord::StreetChanged:
+			writer.Waypoint(osmscout::GeoCoord(record.lat, record.lon), EventName(record, eventCount));
+			eventCount++;
+			break;
+		default:
+			break;
+		}
+	}
+
+	size_t routePoints = 0;
+	reader.Rewind();
+	while (reader.Next(record)) {
+		if (record.type != TelemetryRecord::RoutePoint) continue;
+		if (routePoints++ == 0) writer.BeginRoute("Route");
+		writer.RoutePoint(record.lat, record.lon);
+	}
+	if (routePoints > 0) writer.EndRoute();
+
+	size_t trackPoints = 0;
+	reader.Rewind();
+	while (reader.Next(record)) {
+		if (record.type != TelemetryRecord::TrackPoint) continue;
+		if (trackPoints++ == 0) writer.BeginTrack("GPS");
+		writer.TrackPoint(record.lat, record.lon, record.GetTimestamp(), record.speed);
+	}
+	if (trackPoints > 0) writer.EndTrack();
+
+	if (reader.IsTruncated()) {
+		std::cerr << "The telemetry file is cut off, the last record is missing" << std::endl;
+	}
+
+	if (!writer.Close()) {
+		std::cerr << "Cannot write gpx file!" << std::endl;
+		return 2;
+	}
+
+	std::cout << eventCount << " events, " << routePoints << " route points, " << trackPoints << " track points" << std::endl;
+	return 0;
+}